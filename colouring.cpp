@@ -0,0 +1,172 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  colouring.cpp
+ *
+ *    Description:  Batch colouring of graphs in DIMACS format (.col files). For each
+ *                  graph, a colouring is first found using as many colours as the
+ *                  maximum degree plus one, which always exists, and then the search
+ *                  is repeated with one colour less than the ones actually used,
+ *                  until no colouring is found. Each search can explore, besides
+ *                  one node for each vertex, at most max_nodes further nodes. The
+ *                  connected components of the graph are searched separately, on
+ *                  the given number of threads. When the node limit stops the search,
+ *                  a local search of at most max_steps moves is tried with the same
+ *                  number of colours. The number of colours of the best colouring
+ *                  and the time taken are reported for each graph.
+ *
+ *          Usage:  ./colouring [-n max_nodes] [-t threads] [-l max_steps] <graph.col> [<graph.col> ...]
+ *       Complile:  g++ -IPATH/TO/csp++.h -o colouring colouring.cpp
+ *        Version:  1.0
+ *        Created:  18/10/2026 19:52:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<iostream>
+#include	<vector>
+#include	<cstdlib>
+#include	<cstring>
+#include	<exception>
+#include	<sys/time.h>
+#include	<csp++/csp++.h>
+#include	<csp++/csp++-dimacs.h>
+
+#define 	DEFAULT_MAX_NODES 	1000
+#define 	DEFAULT_THREADS 	1
+#define 	DEFAULT_MAX_STEPS 	0
+
+using namespace std;
+
+/**
+ * FUNCTION: now
+ *
+ * Current time in seconds
+ */
+double
+now ( void )
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * FUNCTION: usedColours
+ *
+ * Given a CSP whose variables are all set, count the different colours used
+ */
+int
+usedColours ( const CSP<int> &csp, int colours )
+{
+	vector<bool> used(colours, false);
+	int count = 0;
+
+	for ( size_t i=0; i < csp.size(); i++ )  {
+		if (!used[csp.value(i)])  {
+			used[csp.value(i)] = true;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * FUNCTION: colour
+ *
+ * Find the colouring of the given graph using the fewest colours within the
+ * given number of search nodes (or local search moves) for each number of
+ * colours, and print a report
+ */
+void
+colour ( const char *file, size_t max_nodes, size_t threads, size_t max_steps )
+{
+	double start = now();
+	CSPgraph g = readDimacsGraph(file);
+	vector<size_t> degree(g.vertices, 0);
+	size_t max_degree = 0;
+	int best = 0;
+	bool optimal = false;
+
+	for ( size_t i=0; i < g.edges.size(); i++ )  {
+		degree[g.edges[i].first]++;
+		degree[g.edges[i].second]++;
+	}
+
+	for ( size_t i=0; i < g.vertices; i++ )
+		max_degree = max(max_degree, degree[i]);
+
+	for ( int colours = max_degree + 1; colours > 0; )  {
+		CSP<int> csp = dimacsColouring(g, colours);
+
+		if (!csp.solveComponents(threads, g.vertices + max_nodes))  {
+			// A complete search without solutions proves the previous colouring optimal
+			optimal = csp.isOptimal();
+
+			if (optimal || max_steps == 0)
+				break;
+
+			csp = dimacsColouring(g, colours);
+
+			if (csp.localSearch(max_steps) > 0)
+				break;
+		}
+
+		best = usedColours(csp, colours);
+		colours = best - 1;
+	}
+
+	cout << file << ": " << g.vertices << " vertices, " << g.edges.size() << " edges, "
+		<< best << " colours" << (optimal ? " (optimal)" : "") << ", "
+		<< (now() - start) << " seconds" << endl;
+}
+
+int
+main ( int argc, char *argv[] )
+{
+	size_t max_nodes = DEFAULT_MAX_NODES;
+	size_t threads = DEFAULT_THREADS;
+	size_t max_steps = DEFAULT_MAX_STEPS;
+	int first = 1;
+
+	while (first + 1 < argc)  {
+		if (!strcmp(argv[first], "-n"))
+			max_nodes = atol(argv[first+1]);
+		else if (!strcmp(argv[first], "-t"))
+			threads = atol(argv[first+1]);
+		else if (!strcmp(argv[first], "-l"))
+			max_steps = atol(argv[first+1]);
+		else
+			break;
+
+		first += 2;
+	}
+
+	if (first >= argc || threads < 1)  {
+		cerr << "Usage: " << argv[0] << " [-n max_nodes] [-t threads] [-l max_steps] <graph.col> [<graph.col> ...]\n";
+		return EXIT_FAILURE;
+	}
+
+	for ( int i=first; i < argc; i++ )  {
+		try  {
+			colour(argv[i], max_nodes, threads, max_steps);
+		}
+
+		catch (const CSPexception &e)  {
+			cerr << argv[i] << ": " << e.what() << endl;
+		}
+
+		catch (const std::exception &e)  {
+			cerr << argv[i] << ": " << e.what() << endl;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -28,7 +28,14 @@
 #define  __CSPPP_VERSION 	"0.1.1"
 
 #include	<vector>
+#include	<set>
+#include	<string>
 #include	<exception>
+#include	<stdint.h>
+#include	<time.h>
+#include	<pthread.h>
+#include	"csp++-expr.h"
+#include	"csp++-table.h"
 
 /**
  * \struct CSPvariable csp++.h
@@ -49,6 +56,223 @@ struct CSPvariable  {
 	std::vector<T> domain;
 };
 
+/**
+ * \class CSPspan csp++.h
+ * \brief Read-only range of values owned by a CSP, e.g. the domain of a variable
+ *        returned by CSP::domainSpan(). It can be used like a constant vector
+ *        without copying the values, until the CSP is changed
+ */
+template<class T>
+class CSPspan  {
+	const T *__data;
+	size_t __size;
+
+public:
+	/**
+	 * \brief Constructor
+	 * \param data Pointer to the first value
+	 * \param size Number of values
+	 */
+	CSPspan ( const T *data, size_t size ) : __data(data), __size(size)  {}
+
+	/**
+	 * \brief  Get the number of values
+	 */
+	size_t size ( void ) const  { return __size; }
+
+	/**
+	 * \brief  Check if the range contains no values
+	 */
+	bool empty ( void ) const  { return __size == 0; }
+
+	/**
+	 * \brief  Get the i-th value
+	 */
+	const T& operator[] ( size_t i ) const  { return __data[i]; }
+
+	/**
+	 * \brief  Iterators over the values
+	 */
+	const T* begin ( void ) const  { return __data; }
+	const T* end ( void ) const  { return __data + __size; }
+};
+
+/**
+ * \class CSPview csp++.h
+ * \brief Read-only view over the variables of a CSP, given to the constraints
+ *        appended through CSP::appendConstraint(bool (*)(const CSPview<T>&)).
+ *        The values of the variables are stored in a single array, the set flags
+ *        in a bitmap and the domains one after the other in a shared pool, so a
+ *        constraint scanning them reads contiguous memory and nothing is copied.
+ *        A view is only valid during the call of the constraint it was given to
+ */
+template<class T>
+class CSPview  {
+	size_t __n;
+	const T *__values;
+	const uint64_t *__fixed;
+	const T *__pool;
+	const size_t *__offsets;
+	const size_t *__sizes;
+
+public:
+	/**
+	 * \brief Constructor, only used by the CSP building the view
+	 */
+	CSPview ( size_t n, const T *values, const uint64_t *fixed, const T *pool,
+			const size_t *offsets, const size_t *sizes )
+		: __n(n), __values(values), __fixed(fixed), __pool(pool), __offsets(offsets), __sizes(sizes)  {}
+
+	/**
+	 * \brief  Get the number of variables
+	 */
+	size_t size ( void ) const  { return __n; }
+
+	/**
+	 * \brief  Check if the i-th variable has a fixed value
+	 */
+	bool isSet ( size_t i ) const  { return (__fixed[i >> 6] >> (i & 63)) & 1; }
+
+	/**
+	 * \brief  Get the value of the i-th variable, only meaningful if it is set
+	 *         or a default value was given to the CSP
+	 */
+	const T& value ( size_t i ) const  { return __values[i]; }
+
+	/**
+	 * \brief  Get the values of all the variables, as an array of size() elements
+	 */
+	const T* values ( void ) const  { return __values; }
+
+	/**
+	 * \brief  Get the domain of the i-th variable, as an array of domainSize(i)
+	 *         elements
+	 */
+	const T* domain ( size_t i ) const  { return __pool + __offsets[i]; }
+
+	/**
+	 * \brief  Get the domain of the i-th variable as a range
+	 */
+	CSPspan<T> domainSpan ( size_t i ) const  { return CSPspan<T>(__pool + __offsets[i], __sizes[i]); }
+
+	/**
+	 * \brief  Get the number of values in the domain of the i-th variable
+	 */
+	size_t domainSize ( size_t i ) const  { return __sizes[i]; }
+};
+
+/**
+ * \brief Consistency levels that can be enforced when propagating the domains,
+ *        from the cheapest to the one pruning most
+ */
+typedef enum  {
+	//! Set variables can only take their value, and the constraints over a
+	//! single variable are applied; the other constraints are only checked
+	//! once all their variables are set
+	CSP_NODE,
+
+	//! The domains of the unset variables are only checked against the set ones
+	CSP_FORWARD,
+
+	//! Each value must have a support in the domains of the other variables
+	CSP_ARC,
+
+	//! Arc consistency, plus each pair of values allowed by the constraints
+	//! between two variables must extend to any third variable constrained
+	//! with both (only constraints between two variables are considered)
+	CSP_PATH,
+
+	//! Arc consistency, plus no value must lead to a domain wipe-out when
+	//! assigned to its variable and arc consistency is enforced
+	CSP_SINGLETON_ARC
+} CSPconsistency;
+
+#define 	CSP_CONSISTENCY_LEVELS 	5
+
+/**
+ * \struct CSPstats csp++.h
+ * \brief Statistics about the propagation of the domains, collected separately for
+ *        each consistency algorithm and indexed by CSPconsistency
+ */
+struct CSPstats  {
+	//! Number of times the algorithm was run
+	size_t runs[CSP_CONSISTENCY_LEVELS];
+
+	//! Time spent running the algorithm, in seconds
+	double seconds[CSP_CONSISTENCY_LEVELS];
+
+	//! Number of values removed from the domains by the algorithm
+	size_t removed[CSP_CONSISTENCY_LEVELS];
+
+	//! Number of propagations looked up in the transposition table
+	size_t lookups;
+
+	//! Number of propagations whose result was found in the transposition table
+	size_t hits;
+
+	//! Number of times the constraints over the whole set of variables were
+	//! sorted again by their profile
+	size_t reorders;
+
+	//! Order in which the constraints over the whole set of variables are
+	//! checked, cheap ones rejecting often first: the ones taking a CSPview are
+	//! numbered from 0 in the order they were appended, followed by the ones
+	//! taking the vector of variables
+	std::vector<size_t> order;
+};
+
+/**
+ * \brief Events on the domain of a variable, which wake up the constraints
+ *        subscribed to them. They can be combined with the | operator
+ */
+typedef enum  {
+	//! Some value was removed from the domain
+	CSP_EVENT_DOMAIN = 1,
+
+	//! The smallest or the largest value of the domain was removed
+	CSP_EVENT_BOUNDS = 2,
+
+	//! The domain was reduced to a single value
+	CSP_EVENT_FIXED = 4
+} CSPevent;
+
+/**
+ * \brief Priority classes of the constraints. When several constraints are waiting
+ *        to be propagated, the ones in the cheapest class are run first
+ */
+typedef enum  {
+	//! Constraints over a single variable
+	CSP_PRIORITY_UNARY,
+
+	//! Constraints between two variables
+	CSP_PRIORITY_BINARY,
+
+	//! Constraints over a few variables, whose cost grows with the product
+	//! of the sizes of their domains
+	CSP_PRIORITY_NARY,
+
+	//! Constraints over the whole set of variables
+	CSP_PRIORITY_GLOBAL
+} CSPpriority;
+
+#define 	CSP_PRIORITY_CLASSES 	4
+
+// The constraints over the whole set of variables are sorted again after this
+// many checks, and one check out of __CSP_PROFILE_EVERY of each one is timed
+#define 	__CSP_REORDER_EVERY 	1024
+#define 	__CSP_PROFILE_EVERY 	16
+
+/**
+ * \brief Current time in seconds, for timing the propagation
+ */
+static inline double
+__csp_now ( void )
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 /**
  * \class CSPexception csp++.h
  * \brief Class for managing exception in CSP
@@ -68,7 +292,7 @@ public:
 	/**
 	 * \brief Return the description of the exception
 	 */
-	virtual const char* what()  {
+	virtual const char* what() const throw()  {
 		return message;
 	}
 };
@@ -80,29 +304,458 @@ public:
 template<class T>
 class CSP  {
 private:
-	template<class TT>
-	struct arc  {
-		CSPvariable<TT> var[2];
-		TT value[2];
-	};
+	// The variables are stored as parallel arrays: their values, a bitmap of
+	// the set ones, and the domains as slices of a single pool. The values a
+	// domain loses are moved past its end, where they stay until the domain
+	// is restored by growing its size back. The position of each value in the
+	// domain given to setDomain() is kept along with it, so the restored
+	// domain gets back its order
+	std::vector<T> __values;
+	std::vector<uint64_t> __fixed;
+	std::vector<T> __pool;
+	std::vector<uint32_t> __positions;
+	std::vector<size_t> __offsets;
+	std::vector<size_t> __sizes;
+	std::vector<size_t> __capacities;
+
+	bool __isFixed ( size_t var ) const  { return (__fixed[var >> 6] >> (var & 63)) & 1; }
+	void __setFixed ( size_t var, bool fixed );
+	T* __domain ( size_t var )  { return __pool.empty() ? NULL : &__pool[0] + __offsets[var]; }
+	const T* __domain ( size_t var ) const  { return __pool.empty() ? NULL : &__pool[0] + __offsets[var]; }
+	void __allocate ( size_t var, size_t size );
+	void __setDefaultDomain ( size_t var );
+	void __restoreDomain ( size_t var );
 
-	std::vector< CSPvariable<T> > variables;
 	std::vector< bool (*)(std::vector< CSPvariable<T> >) > constraints;
 	#define 	constraint 	constraints[0]
+	std::vector< bool (*)(const CSPview<T>&) > __view_constraints;
+
+	/**
+	 * \struct __profile
+	 * \brief  Profile of a constraint over the whole set of variables: how many
+	 *         times it was checked and rejected the variables, and the time taken
+	 *         by the checks which were timed
+	 */
+	struct __profile  {
+		size_t checks;
+		size_t rejections;
+		size_t timed;
+		double seconds;
+	};
+
+	struct __byRank  {
+		const std::vector<double> &rank;
+		__byRank ( const std::vector<double> &r ) : rank(r)  {}
+		bool operator() ( size_t a, size_t b ) const  { return rank[a] < rank[b]; }
+	};
+
+	// The constraints over the whole set of variables are checked in the order
+	// of __legacy_order (the ones taking a view first, as in __checkLegacy()),
+	// which is sorted again every __CSP_REORDER_EVERY checks by their profile
+	std::vector<size_t> __legacy_order;
+	std::vector< __profile > __profiles;
+	size_t __checks;
+
+	void __resetOrder ( void );
+	void __reorderLegacy ( void );
+
+	// Constraints over the whole set of variables turned by inferScopes() into
+	// the constraints between two variables they are made of, which are no
+	// longer probed, and the propagators of those constraints
+	std::vector< bool (*)(std::vector< CSPvariable<T> >) > __inferred_constraints;
+	std::vector< bool (*)(const CSPview<T>&) > __inferred_views;
+	std::vector<size_t> __inferred_ids;
+
+	// Copy of the variables in the layout of CSPvariable, for the constraints,
+	// objectives and callbacks taking a vector of them. While __synced is set,
+	// it is kept up to date by each change instead of being built again
+	std::vector< CSPvariable<T> > __variables;
+	bool __synced;
+
+	const std::vector< CSPvariable<T> >& __materialise ( void );
+	void __setState ( size_t var, bool fixed, const T &value );
+	void __sync ( size_t var );
+	bool __satisfied ( bool inferred = true );
 
 	std::vector< std::vector<T> > __default_domains;
 	T __default_value;
 	bool __has_default_value;
-	static bool __default_constraint ( std::vector< CSPvariable<T> > v )  { return true; }
+	static bool __default_constraint ( std::vector< CSPvariable<T> > )  { return true; }
 	void __init ( int n, bool (*c)(std::vector< CSPvariable<T> >) );
 	void restoreDomains ( void );
 
+	/**
+	 * \struct __frame
+	 * \brief  A choice point of the search: the variable being branched on, the
+	 *         values of its domain when the branch was opened and the next one to try
+	 */
+	struct __frame  {
+		size_t var;
+		std::vector<T> values;
+		size_t next;
+		size_t trail;
+	};
+
+	/**
+	 * \struct __binary
+	 * \brief  Constraint between two variables, expressed by a relation that must
+	 *         hold between their values, or by a function finding at once which
+	 *         values of a domain have a support in the other one
+	 */
+	struct __binary  {
+		size_t x;
+		size_t y;
+		bool (*rel)(T, T);
+		void (*support)(const T*, size_t, const T*, size_t, bool, char*);
+	};
+
+	/**
+	 * \struct __scoped
+	 * \brief  Constraint over a given list of variables, expressed by a function
+	 *         checking the values they take
+	 */
+	struct __scoped  {
+		std::vector<size_t> scope;
+		bool (*check)(const std::vector<T>&);
+	};
+
+	/**
+	 * \struct __propagator
+	 * \brief  Entry of the propagation engine: the method narrowing the domains
+	 *         for a constraint, the index of the constraint among the ones of its
+	 *         kind and the variables it depends on. An idempotent propagator
+	 *         reaches a fixed point in one run, so it isn't woken up again by the
+	 *         changes it makes itself. The entry of a removed constraint is kept,
+	 *         with no method, so that the ids of the others don't change
+	 */
+	struct __propagator  {
+		bool (CSP<T>::*run)(size_t);
+		size_t data;
+		std::vector<size_t> scope;
+		CSPpriority priority;
+		unsigned events;
+		bool idempotent;
+	};
+
+	/**
+	 * \struct __expression
+	 * \brief  Constraint appended as an expression: its variables, the position
+	 *         in the scope of the variable of each leaf of the expression, the
+	 *         constants of the leaves and the function evaluating it on the values
+	 *         of the leaves. The linear ones also keep the coefficient of each
+	 *         variable and the constant of their difference l - r
+	 */
+	struct __expression  {
+		std::vector<size_t> scope;
+		std::vector<size_t> leaves;
+		std::vector<T> constants;
+		std::vector<T> coefficients;
+		T constant;
+		bool (*check)(const T*, size_t, const T*);
+	};
+
+	/**
+	 * \struct __inferred
+	 * \brief  Constraint between two variables, or over a single one when x and y
+	 *         are the same, inferred from the constraints over the whole set of
+	 *         variables: whether each pair of values is accepted, indexed by the
+	 *         positions of the values in the domains given to setDomain()
+	 */
+	struct __inferred  {
+		size_t x;
+		size_t y;
+		std::vector<char> allowed;
+	};
+
+	std::vector< std::pair<size_t, bool (*)(T)> > __unaries;
+	std::vector< __binary > __binaries;
+	std::vector< __scoped > __scopeds;
+	std::vector< __expression > __expressions;
+	std::vector< __inferred > __inferreds;
+
+	std::vector< __propagator > __propagators;
+	std::vector< std::vector< std::pair<size_t, unsigned> > > __subscribers;
+	std::vector<size_t> __queues[CSP_PRIORITY_CLASSES];
+	size_t __heads[CSP_PRIORITY_CLASSES];
+	std::vector<bool> __queued;
+	long __running;
+
+	// Propagator which removed each value missing from a domain, indexed as the
+	// pool by the original position of the value (-1 if it wasn't removed by a
+	// propagator, e.g. by the value of a set variable). While __propagated is
+	// set, the domains are the ones found by refreshDomains(), and only the
+	// constraints appended or removed since then need to be propagated
+	std::vector<long> __causes;
+	bool __propagated;
+	std::vector<size_t> __appended;
+	std::vector<size_t> __removed_constraints;
+
+	bool __giveBack ( size_t var, long cause );
+	void __relax ( void );
+	bool __update ( void );
+
+	// Zobrist hash of the state a propagation starts from: the keys of the
+	// values missing from the domains given to setDomain(), the keys of the
+	// values of the set variables, and the stamp of the constraints and of the
+	// domains, a new one each time they change (the constraints hold function
+	// pointers and values of type T, which can't be hashed in general, so the
+	// results are only shared by the copies of a CSP). It is only kept up to
+	// date while a transposition table is given, for looking up the result of
+	// propagating the same state again
+	CSPtranspositions *__transpositions;
+	uint64_t __model;
+	uint64_t __zobrist;
+	std::vector<uint64_t> __zobrist_removed;
+	std::vector<uint64_t> __zobrist_set;
+
+	void __restamp ( void )  { __model = __csp_stamp(); }
+	uint64_t __key ( void ) const  { return __zobrist ^ __csp_zobrist(__model, __consistency); }
+	void __toggle ( size_t var, size_t from, size_t to );
+	void __hashDomain ( size_t var );
+	void __hashValue ( size_t var );
+	void __rehash ( void );
+	bool __recall ( uint64_t key, bool &consistent, bool replay );
+	void __remember ( uint64_t key, bool consistent, bool exact );
+
+	void __addPropagator ( bool (CSP<T>::*run)(size_t), size_t data, const std::vector<size_t> &scope,
+			CSPpriority priority, unsigned events, bool idempotent );
+	void __notify ( size_t var, unsigned events );
+	void __schedule ( size_t p );
+	void __scheduleAll ( void );
+	void __clearQueues ( void );
+	bool __runQueue ( void );
+	bool __runPropagator ( size_t p );
+	void __bounds ( size_t var, T &lo, T &hi );
+	bool __narrow ( size_t var, const std::vector<char> &keep );
+	void __narrowed ( size_t var, size_t old_size, const T &lo, const T &hi );
+	void __restore ( size_t var, size_t size );
+	std::vector<T> __spare;
+	std::vector<uint32_t> __spare_positions;
+	bool __propagateUnary ( size_t u );
+	bool __propagateBinary ( size_t b );
+	bool __propagateScoped ( size_t s );
+	bool __propagateLegacy ( size_t unused );
+	bool __propagateInferred ( size_t i );
+	bool __reviseInferred ( size_t x, const __inferred &c );
+	template<class E> bool __propagateExpression ( size_t e );
+	template<class Op> bool __propagateLinear ( size_t e );
+	bool __propagateAllDifferent ( size_t e );
+
+	template<class Op> size_t __lower ( const __csp_relation< T, Op, CSPvar<T>, CSPvar<T> > &c );
+	template<class Op, class L, class R> size_t __lower ( const __csp_relation<T, Op, L, R> &c );
+	template<class E> size_t __lower ( const E &c );
+	size_t __lowerPair ( size_t x, size_t y, __csp_eq );
+	size_t __lowerPair ( size_t x, size_t y, __csp_ne );
+	template<class Op> size_t __lowerPair ( size_t x, size_t y, Op );
+	template<class Op> static void __orderSupport ( const T *values, size_t n, const T *other, size_t m,
+			bool first, char *mask );
+	template<class Op, class L, class R> size_t __lowerExpression ( const __csp_relation<T, Op, L, R> &c,
+			__csp_flag<true> );
+	template<class E> size_t __lowerExpression ( const E &c, __csp_flag<false> );
+	void __leaves ( const std::vector<size_t> &vars, __expression &e );
+	size_t __addExpression ( const __expression &e, bool (CSP<T>::*run)(size_t), unsigned events );
+	template<class E> static bool __evaluate ( const T *x, size_t n, const T *k );
+	static bool __distinct ( const T *x, size_t n, const T *k );
+
+	CSPconsistency __consistency;
+	bool __probe_fixed;
+	CSPstats __stats;
+	size_t __removed;
+
+	bool __runPropagation ( const size_t *var );
+	void __record ( CSPconsistency level, double start, size_t removed );
+	bool __nodeConsistency ( void );
+	bool __nodeConsistency ( size_t var );
+	bool __checkSet ( const size_t *var );
+	bool __checkComplete ( void );
+	void __emptyDomain ( size_t var );
+	bool __forwardChecking ( const size_t *var );
+	bool __arcPass ( void );
+	void __legacyProbe ( void );
+	bool __pathConsistency ( void );
+	bool __singletonArcConsistency ( void );
+	bool __singletonPass ( size_t x );
+
+	bool __hasLegacyConstraints ( void ) const;
+	bool __hasVectorConstraints ( void ) const;
+	bool __hasProbedConstraints ( void ) const;
+	bool __isInferred ( bool (*c)(std::vector< CSPvariable<T> >) ) const;
+	bool __isInferred ( bool (*c)(const CSPview<T>&) ) const;
+	bool __checkLegacy ( size_t k );
+	void __dropInferred ( void );
+	bool __revise ( size_t x, const __binary &c );
+	void __supported ( const __binary &c, bool first, const T *values, size_t n,
+			const T *other, size_t m, std::vector<char> &mask );
+	std::vector<char> __mask;
+
+	/**
+	 * \struct __saved
+	 * \brief  Entry of the trail: the size the domain of a variable had before
+	 *         being narrowed. The removed values are still in its slice of the
+	 *         pool, right past the end of the domain
+	 */
+	struct __saved  {
+		size_t var;
+		size_t size;
+	};
+
+	std::vector< __saved > __trail;
+	bool __trailing;
+	bool __incremental;
+
+	struct __byDegree  {
+		const std::vector<size_t> &degree;
+		__byDegree ( const std::vector<size_t> &d ) : degree(d)  {}
+		bool operator() ( size_t a, size_t b ) const  { return degree[a] > degree[b]; }
+	};
+
+	std::set< std::pair<size_t, size_t> > __order;
+	std::vector< size_t > __ranks;
+	std::vector< size_t > __ranked;
+	std::vector< std::vector<size_t> > __class_use;
+
+	void __save ( size_t var );
+	void __reorder ( size_t var, size_t old_size );
+	void __undo ( size_t mark );
+	void __startSearch ( void );
+	void __assign ( size_t var, T value );
+	void __unassign ( size_t var );
+	bool __propagate ( size_t var );
+	long __valueClass ( size_t c, T value );
+
+	std::vector< __frame > __frames;
+	size_t __nodes;
+	bool __search_complete;
+
+	double (*__objective)(std::vector< CSPvariable<T> >);
+	long __objective_var;
+	bool __maximise;
+	bool (*__incumbent_callback)(std::vector< CSPvariable<T> >, double);
+	bool __bounding;
+	bool __has_incumbent;
+	double __incumbent;
+	std::vector<T> __best;
+
+	std::vector< std::vector<T> > __value_symmetries;
+	std::vector< std::vector<size_t> > __variable_symmetries;
+	bool __counting;
+	size_t __solutions;
+	size_t __solutions_limit;
+
+	std::string __checkpoint_file;
+	size_t __checkpoint_every;
+	bool __resuming;
+
+	/**
+	 * \struct __snapshot_header
+	 * \brief  Header of a checkpoint file. It is followed by the sections it
+	 *         points to, each one a plain array which is copied back as it is
+	 *         once the file is mapped in memory and checked
+	 */
+	struct __snapshot_header  {
+		char magic[8];
+		uint32_t version;
+		uint32_t value_size;
+		uint64_t variables;
+		uint64_t pool_size;
+		uint64_t frames;
+		uint64_t frame_pool_size;
+		uint64_t trail;
+		uint64_t nodes;
+		uint64_t solutions;
+		uint32_t counting;
+		uint32_t has_incumbent;
+		double incumbent;
+
+		// Offsets of the sections, in bytes from the beginning of the file
+		uint64_t variables_offset;
+		uint64_t values_offset;
+		uint64_t pool_offset;
+		uint64_t positions_offset;
+		uint64_t frames_offset;
+		uint64_t frame_pool_offset;
+		uint64_t trail_offset;
+		uint64_t best_offset;
+		uint64_t file_size;
+	};
+
+	struct __snapshot_variable  {
+		uint64_t domain_offset;
+		uint64_t domain_size;
+		uint64_t slice_size;
+		uint64_t fixed;
+	};
+
+	struct __snapshot_frame  {
+		uint64_t var;
+		uint64_t next;
+		uint64_t values_offset;
+		uint64_t values_size;
+		uint64_t trail;
+	};
+
+	struct __snapshot_saved  {
+		uint64_t var;
+		uint64_t size;
+	};
+
+	const char* __snapshotError ( const char *base, uint64_t size ) const;
+
+	/**
+	 * \struct __component
+	 * \brief  Connected component of the constraint graph, solved as a separate
+	 *         CSP by solveComponents(), possibly on its own thread
+	 */
+	struct __component  {
+		std::vector<size_t> vars;
+		CSP<T> *csp;
+		size_t max_nodes;
+		bool found;
+	};
+
+	/**
+	 * \struct __componentQueue
+	 * \brief  Components shared by the threads of solveComponents(), each thread
+	 *         taking the next one to solve until none is left
+	 */
+	struct __componentQueue  {
+		std::vector< __component > *components;
+		size_t next;
+		bool failed;
+		pthread_mutex_t lock;
+
+		// The first exception thrown while solving a component, thrown again
+		// on the calling thread once all the threads are joined
+#if __cplusplus >= 201103L
+		std::exception_ptr error;
+#else
+		const char *error;
+#endif
+	};
+
+	void __subproblem ( const std::vector<size_t> &vars, CSP<T> &sub );
+	static void* __solveComponents ( void *queue );
+
+	bool __symmetryConsistent ( void );
+	void __breakValueSymmetries ( std::vector<T> &values );
+
+	double __cost ( void );
+	bool __improves ( double cost );
+	void __applyBound ( void );
+	bool __consistent ( void );
+	long __selectVariable ( void );
+	bool __onSolution ( void );
+	void __search ( size_t max_nodes );
+
+	static uint64_t __random ( uint64_t &state );
+	bool __violated ( size_t p, std::vector<T> &tuple );
+
 public:
 	/**
 	 * \brief Empty constructor - just do nothing, used for declaring an object and
 	 *        initialize it later
 	 */
-	CSP()  {}
+	CSP()  { __init (0, __default_constraint); }
 	
 	/**
 	 * \brief  Class constructor
@@ -131,14 +784,28 @@ public:
 	CSP ( int n, T default_value, bool set_variables = false, bool (*c)(std::vector< CSPvariable<T> >) = __default_constraint );
 
 	/**
-	 * \brief  Set the domain for the i-th variable
+	 * \brief  Set the domain for the i-th variable. The values are sorted and
+	 *         the duplicates dropped, and the domain returned by domain() keeps
+	 *         them in this order
+	 * \param  index Variable for which we're setting the domain
+	 * \param  domain Vector containing the possible values for that variable
+	 */
+	void setDomain ( size_t index, const std::vector<T> &domain );
+
+#if __cplusplus >= 201103L
+	/**
+	 * \brief  Set the domain for the i-th variable, taking over the given vector
+	 *         instead of copying it. The values are sorted and the duplicates
+	 *         dropped
 	 * \param  index Variable for which we're setting the domain
 	 * \param  domain Vector containing the possible values for that variable
 	 */
-	void setDomain ( size_t index, std::vector<T> domain );
+	void setDomain ( size_t index, std::vector<T> &&domain );
+#endif
 
 	/**
-	 * \brief  Set the domain for the i-th variable
+	 * \brief  Set the domain for the i-th variable. The values are sorted and
+	 *         the duplicates dropped
 	 * \param  index Variable for which we're setting the domain
 	 * \param  domain Array containing the possible values for that variable
 	 * \param  size Size of "domain" array
@@ -156,7 +823,143 @@ public:
 	 * \param  c Vector containing pointers to boolean functions representing
 	 *           the constraints of the CSP
 	 */
-	void setConstraint ( std::vector< bool(*)(std::vector< CSPvariable<T> >) > c );
+	void setConstraint ( const std::vector< bool(*)(std::vector< CSPvariable<T> >) > &c );
+
+	/**
+	 * \brief  Append a constraint over a single variable to the CSP. It is applied
+	 *         once to the domain of the variable, before any other constraint
+	 * \param  x Index of the variable
+	 * \param  c Function returning true if the given value of x is allowed
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	size_t appendConstraint ( size_t x, bool (*c)(T) );
+
+	/**
+	 * \brief  Append a constraint between two variables to the CSP. Unlike the
+	 *         constraints over the whole set of variables, the library knows which
+	 *         variables are involved, so it can propagate it by arc consistency
+	 *         only where the domains change, which scales to large CSPs
+	 * \param  x Index of the first variable
+	 * \param  y Index of the second variable
+	 * \param  c Function returning true if the given values of x and y (in this
+	 *           order) are compatible, e.g. CSP<T>::notEqual
+	 * \param  events Events on the domains of x and y (CSPevent values or'ed
+	 *           together) after which the constraint must be propagated again.
+	 *           E.g. a relation like x < y only needs CSP_EVENT_BOUNDS. The
+	 *           built-in relations CSP<T>::notEqual, CSP<T>::lessThan and
+	 *           CSP<T>::equal always use the events they need, and are checked
+	 *           on whole domains through notEqualSupport(), lessThanSupport()
+	 *           and equalSupport()
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	size_t appendConstraint ( size_t x, size_t y, bool (*c)(T, T), unsigned events = CSP_EVENT_DOMAIN );
+
+	/**
+	 * \brief  Append a constraint between two variables to the CSP, given as a
+	 *         function checking a whole domain at once instead of a pair of values
+	 * \param  x Index of the first variable
+	 * \param  y Index of the second variable
+	 * \param  s Function taking the values of a domain and their number, the
+	 *           domain of the other variable and its size, whether the values are
+	 *           taken by x (true) or by y (false), and a mask with one element for
+	 *           each value, which must be set to 1 if the value has a support in
+	 *           the other domain and to 0 otherwise. E.g. CSP<T>::notEqualSupport
+	 * \param  events Events on the domains of x and y after which the constraint
+	 *           must be propagated again
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	size_t appendConstraint ( size_t x, size_t y,
+			void (*s)(const T*, size_t, const T*, size_t, bool, char*),
+			unsigned events = CSP_EVENT_DOMAIN );
+
+	/**
+	 * \brief  Append a constraint over a list of variables to the CSP. Each value
+	 *         left in their domains must belong to some combination of values
+	 *         accepted by the constraint, which is found by trying all of them, so
+	 *         the constraint should only involve a few variables
+	 * \param  scope Indexes of the variables involved, all different
+	 * \param  c Function returning true if the given values of the variables (in
+	 *           the order of scope) are compatible
+	 * \param  priority Priority class of the constraint: it is only propagated
+	 *           when no constraint in a cheaper class is waiting
+	 * \param  events Events on the domains of the variables (CSPevent values or'ed
+	 *           together) after which the constraint must be propagated again
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	size_t appendConstraint ( const std::vector<size_t> &scope, bool (*c)(const std::vector<T>&),
+			CSPpriority priority = CSP_PRIORITY_NARY, unsigned events = CSP_EVENT_DOMAIN );
+
+	/**
+	 * \brief  Append a constraint written as an expression over variable handles,
+	 *         e.g. CSPvar<int>(0) + CSPvar<int>(1) == CSPvar<int>(2). The
+	 *         propagator is chosen at compile time from the shape of the
+	 *         expression: a relation between two variables is propagated like the
+	 *         built-in binary relations, a relation between sums of variables
+	 *         multiplied by constants on the bounds of the domains, and any other
+	 *         expression (e.g. implies(a, b)) like a constraint over its variables,
+	 *         with the expression evaluated inline
+	 * \param  c Expression built from CSPvar handles, constants, the operators
+	 *           + - * == != < <= > >= && || ! and implies()
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	template<class E>
+	size_t appendConstraint ( const CSPconstraint<T, E> &c );
+
+	/**
+	 * \brief  Append a constraint requiring some variables to take different
+	 *         values. The values of the variables reduced to a single value are
+	 *         removed from the other domains (naked singles), the constraint fails
+	 *         when the domains hold fewer values than there are variables, and
+	 *         when they hold as many, a value left in a single domain is assigned
+	 *         to its variable (hidden singles)
+	 * \param  c Constraint, as returned by allDifferent()
+	 * \return The id of the constraint, for removeConstraint()
+	 */
+	size_t appendConstraint ( const CSPallDifferent<T> &c );
+
+	/**
+	 * \brief  Relation for appendConstraint(), true if the two values are different
+	 */
+	static bool notEqual ( T a, T b )  { return a != b; }
+
+	/**
+	 * \brief  Relation for appendConstraint(), true if the first value is smaller
+	 */
+	static bool lessThan ( T a, T b )  { return a < b; }
+
+	/**
+	 * \brief  Relation for appendConstraint(), true if the two values are equal
+	 */
+	static bool equal ( T a, T b )  { return a == b; }
+
+	/**
+	 * \brief  Domain form of notEqual(): a value is supported unless the other
+	 *         domain only contains that value
+	 */
+	static void notEqualSupport ( const T *values, size_t n, const T *other, size_t m,
+			bool first, char *mask );
+
+	/**
+	 * \brief  Domain form of lessThan(): a value is supported if it is smaller than
+	 *         the largest value of the other domain (or larger than the smallest
+	 *         one, when the values are taken by the second variable)
+	 */
+	static void lessThanSupport ( const T *values, size_t n, const T *other, size_t m,
+			bool first, char *mask );
+
+	/**
+	 * \brief  Domain form of equal(): a value is supported if the other domain
+	 *         contains it too
+	 */
+	static void equalSupport ( const T *values, size_t n, const T *other, size_t m,
+			bool first, char *mask );
+
+	/**
+	 * \brief  Remove a constraint appended on some variables. The ids of the other
+	 *         constraints don't change
+	 * \param  id Id of the constraint, as returned by appendConstraint()
+	 */
+	void removeConstraint ( size_t id );
 
 	/**
 	 * \brief  Drops a constraint from the CSP
@@ -171,12 +974,107 @@ public:
 	void appendConstraint ( bool (*c)(std::vector< CSPvariable<T> >) );
 
 	/**
-	 * \brief  Updates the domains of the variables. Any constraint or node fixed value is applied
-	 * \param  max_iterations Maximum number of iterations, after which the function will quit. This
-	 *         can be used to break endless loops in domains assignations.
+	 * \brief  Append a constraint over the whole set of variables, which reads
+	 *         them through a view instead of a copy of the vector of variables.
+	 *         It is checked like the ones taking the vector, but much faster
+	 * \param  c Function returning true if the variables seen through the view
+	 *           satisfy the constraint
+	 */
+	void appendConstraint ( bool (*c)(const CSPview<T>&) );
+
+	/**
+	 * \brief  Find which variables the constraints over the whole set of variables
+	 *         involve, so that they are propagated like constraints between two
+	 *         variables, only where the domains change, instead of by probing
+	 *         every pair of variables. Each constraint is checked with each value
+	 *         of each variable and with each pair of values of each pair of
+	 *         variables, all the other variables being unset and holding the
+	 *         default value (or T() if none was given): the pairs it rejects make
+	 *         a constraint between their two variables. A constraint rejecting the
+	 *         state with no variable set, accepting a pair with a value it rejects
+	 *         alone, or rejecting no value nor pair at all may depend on more
+	 *         than pairs of variables, so it is still probed. All the
+	 *         constraints are still checked when all the variables are set. The
+	 *         result is dropped when the domains are set or the constraints over
+	 *         the whole set of variables are set or dropped; the ones appended
+	 *         afterwards are probed
+	 * \return The number of constraints propagated through their pairs of
+	 *         variables
+	 */
+	size_t inferScopes ( void );
+
+	/**
+	 * \brief  Updates the domains of the variables. Any constraint or node fixed value is applied.
+	 *         At arc consistency, once the domains are propagated, the constraints appended
+	 *         or removed afterwards are applied incrementally, as long as no variable or
+	 *         domain is changed in between: an appended constraint is only propagated from
+	 *         its own variables on the current domains, while a removed one gives back the
+	 *         values it had removed, along with the ones removed by other constraints
+	 *         because of them, which are then propagated again
 	 */
 	void refreshDomains ( void );
 
+	/**
+	 * \brief  Set the consistency level enforced by refreshDomains() and at each
+	 *         node of the searches. Cheaper levels prune less: forward checking is
+	 *         usually enough for easy CSPs, while path or singleton arc consistency
+	 *         can save a lot of search on hard ones. The default is CSP_ARC
+	 * \param  level Consistency level
+	 */
+	void setConsistency ( CSPconsistency level );
+
+	/**
+	 * \brief  Choose how the constraints over the whole set of variables see the
+	 *         variables whose values are being tried by the propagation. By
+	 *         default they only take the values being tried, and keep being
+	 *         unset, so a constraint can still compare the unset variables with
+	 *         their default value. If fixed is true, they are also marked as set
+	 *         while the constraints are checked, so constraints only checking the
+	 *         set variables see them
+	 * \param  fixed Whether the variables being tried are marked as set
+	 */
+	void setProbeFixed ( bool fixed );
+
+	/**
+	 * \brief  Get the consistency level enforced when propagating the domains
+	 * \return The current consistency level
+	 */
+	CSPconsistency consistency ( void ) const;
+
+	/**
+	 * \brief  Get the time spent and the number of values removed by each of the
+	 *         consistency algorithms since the creation of the CSP or the last call
+	 *         to resetStats()
+	 * \return The statistics of the propagation
+	 */
+	CSPstats stats ( void ) const;
+
+	/**
+	 * \brief  Reset the statistics returned by stats()
+	 */
+	void resetStats ( void );
+
+	/**
+	 * \brief  Keep the results of the propagation in a transposition table, and
+	 *         look them up before propagating. The state the propagation starts
+	 *         from (the values of the set variables and the values missing from the
+	 *         domains) is hashed incrementally, along with a stamp of the
+	 *         constraints and of the domains given to setDomain(): refreshDomains()
+	 *         replays the domains found the last time the same state was
+	 *         propagated, and the search skips the states already found
+	 *         inconsistent. The stamp is a new one each time the constraints or
+	 *         the domains change, not a hash of them, so the results are only
+	 *         shared by a CSP and its copies made since: two CSPs built apart
+	 *         with the same constraints never find each other's results, and only
+	 *         share the room of the table. The table can be used by several CSPs
+	 *         on different threads. It isn't used (neither looked up nor filled)
+	 *         while the CSP has constraints over the whole set of variables,
+	 *         which can read the values of the variables not set
+	 * \param  table Transposition table, which must outlive the CSP, or NULL to
+	 *           stop using it
+	 */
+	void setTranspositions ( CSPtranspositions *table );
+
 	/**
 	 * \brief Get, if it exists, the solution of the CSP, calling refreshDomains until a fixed point
 	 *        is reached
@@ -188,13 +1086,36 @@ public:
 	 * \param  index Variable for which we're going to get the domain
 	 * \return The domain of the i-th variable as a vector of T
 	 */
-	std::vector<T> domain ( size_t index );
+	std::vector<T> domain ( size_t index ) const;
+
+	/**
+	 * \brief  Get the domain of the i-th variable without copying it. The range
+	 *         is only valid until the domains of the CSP are changed
+	 * \param  index Variable for which we're going to get the domain
+	 * \return The domain of the i-th variable as a range of T
+	 */
+	CSPspan<T> domainSpan ( size_t index ) const;
+
+	/**
+	 * \brief  Get the number of values in the domain of the i-th variable
+	 * \param  index Variable for which we're going to get the size of the domain
+	 * \return The size of the domain of the i-th variable
+	 */
+	size_t domainSize ( size_t index ) const;
+
+	/**
+	 * \brief  Get a view over all the variables, their values and their domains,
+	 *         as seen by the constraints taking a CSPview. The view is only valid
+	 *         until the CSP is changed
+	 * \return The view over the variables of the CSP
+	 */
+	CSPview<T> view ( void ) const;
 
 	/**
 	 * \brief  Get the number of variables in the current CSP
 	 * \return Size of the CSP
 	 */
-	size_t size ( void );
+	size_t size ( void ) const;
 	
 	/**
 	 * \brief  Set the value of a variable as a constraint
@@ -216,7 +1137,7 @@ public:
 	 * \brief  Check if the current CSP, with the applied constraints, is satisfiable
 	 * \return true if the CSP has at least a possible solution, false otherwise
 	 */
-	bool isSatisfiable ( void );
+	bool isSatisfiable ( void ) const;
 
 	/**
 	 * \brief  Check if the CSP, with the given variables, domains and constraints,
@@ -224,7 +1145,7 @@ public:
 	 *         an only element
 	 * \return true if the CSP has an only possible solution, false otherwise
 	 */
-	bool hasUniqueSolution ( void );
+	bool hasUniqueSolution ( void ) const;
 
 	/**
 	 * \brief  Check if any of the variables in the CSP has a domain containing an only
@@ -237,7 +1158,7 @@ public:
 	 * \param  i Index of the variable to be checked
 	 * \return true if the i-th variable has a fixed value, false otherwise
 	 */
-	bool isSet ( size_t i );
+	bool isSet ( size_t i ) const;
 
 	/**
 	 * \brief  Get the value of the i-th variable of the CSP. Be careful: before
@@ -248,7 +1169,185 @@ public:
 	 * \param  i Index of the variable to get
 	 * \return The value of the variable, if the variable exists
 	 */
-	T value ( size_t i );
+	const T& value ( size_t i ) const;
+
+	/**
+	 * \brief  Use the value of a variable as objective of optimise(). The variable
+	 *         must hold values convertible to double
+	 * \param  index Index of the variable to be minimised (or maximised)
+	 * \param  maximise If true, the variable is maximised instead of minimised
+	 */
+	void setObjective ( size_t index, bool maximise = false );
+
+	/**
+	 * \brief  Use a function of the variables as objective of optimise(). The function
+	 *         is also evaluated on partial assignments for pruning the search, so for
+	 *         a partial assignment it must return a value that no completion of that
+	 *         assignment can improve (e.g. the cost of the fixed variables only, when
+	 *         minimising a sum of non-negative costs)
+	 * \param  f Function returning the cost of the given variables
+	 * \param  maximise If true, the function is maximised instead of minimised
+	 */
+	void setObjective ( double (*f)(std::vector< CSPvariable<T> >), bool maximise = false );
+
+	/**
+	 * \brief  Set a function called by optimise() each time a solution better than
+	 *         the previous ones is found
+	 * \param  f Function taking the variables of the new solution and its cost. If
+	 *         it returns false, the search is stopped and the current solution is kept
+	 */
+	void setIncumbentCallback ( bool (*f)(std::vector< CSPvariable<T> >, double) );
+
+	/**
+	 * \brief  Find the solution of the CSP minimising (or maximising) the objective
+	 *         set through setObjective(), using a branch-and-bound search. Every time
+	 *         a better solution is found the bound is tightened, and the domains are
+	 *         pruned accordingly in the rest of the search. If no objective is set,
+	 *         the search stops at the first solution found. When a solution is
+	 *         found, all the variables are set to its values. If the CSP only has
+	 *         constraints between two variables, the domains are propagated
+	 *         incrementally at each node of the search instead of being computed
+	 *         again by refreshDomains()
+	 * \param  max_nodes Maximum number of search nodes to be explored (0 = no limit)
+	 * \return true if a solution was found, false otherwise
+	 */
+	bool optimise ( size_t max_nodes = 0 );
+
+	/**
+	 * \brief  Get the objective value of the best solution found by optimise() or
+	 *         solveComponents(). An exception is thrown if no objective was set or
+	 *         no solution was found
+	 * \return The cost of the best solution
+	 */
+	double objectiveValue ( void ) const;
+
+	/**
+	 * \brief  Check whether the last optimise() explored the whole search space, i.e.
+	 *         it was neither stopped by the node limit nor by the incumbent callback
+	 * \return true if the solution found is proved optimal (or the CSP is proved
+	 *         unsatisfiable), false otherwise
+	 */
+	bool isOptimal ( void ) const;
+
+	/**
+	 * \brief  Get the connected components of the constraint graph, i.e. the groups
+	 *         of variables linked, directly or through other variables, by some
+	 *         constraint. The constraints over the whole set of variables link all
+	 *         the variables together
+	 * \return A vector containing, for each component, the sorted indexes of its
+	 *         variables. The components are sorted by their first variable
+	 */
+	std::vector< std::vector<size_t> > components ( void ) const;
+
+	/**
+	 * \brief  Find a solution of the CSP by splitting it into the connected
+	 *         components of the constraint graph, which are propagated and searched
+	 *         as separate CSPs, so the search spaces of unrelated sub-problems are
+	 *         never multiplied together. The solutions of the components are then
+	 *         merged, and the variables set to their values as in optimise(). An
+	 *         objective set on a variable is optimised within its component, while
+	 *         an objective function can't be split, so a CSP with one is searched
+	 *         as a whole by optimise()
+	 * \param  threads Number of threads solving the components in parallel
+	 * \param  max_nodes Maximum number of search nodes for each component (0 = no
+	 *         limit)
+	 * \return true if every component has a solution, false otherwise
+	 */
+	bool solveComponents ( size_t threads = 1, size_t max_nodes = 0 );
+
+	/**
+	 * \brief  Look for a solution through a local search instead of a complete one,
+	 *         for the CSPs too large to be propagated and searched. Each variable
+	 *         not set takes a random value of its domain, and then, at each step, a
+	 *         variable involved in some violated constraint is moved to the value of
+	 *         its domain violating the fewest constraints (min-conflicts). The value
+	 *         left is kept out of reach of the variable for some steps (tabu), unless
+	 *         moving back to it gives an assignment better than any found so far, and
+	 *         with a given probability a random value is taken instead (random walk).
+	 *         The number of violated constraints is updated after each move only for
+	 *         the constraints involving the variable moved, while the constraints
+	 *         over the whole set of variables are checked again at each move. The
+	 *         variables already set are never moved. At the end, all the variables
+	 *         are set to the assignment with the fewest violated constraints found.
+	 *         The search is incomplete: it can't prove that a CSP has no solution
+	 * \param  max_steps Maximum number of moves
+	 * \param  walk Probability of moving a variable to a random value
+	 * \param  tenure Number of steps a value is tabu for after being left
+	 * \param  seed Seed of the random choices
+	 * \return The number of constraints violated by the assignment found (0 if it
+	 *         is a solution)
+	 */
+	size_t localSearch ( size_t max_steps, double walk = 0.01, size_t tenure = 2, uint64_t seed = 1 );
+
+	/**
+	 * \brief  Declare a set of values as interchangeable, i.e. any permutation of
+	 *         these values maps a solution of the CSP (and its objective, if any) to
+	 *         another solution. The search in optimise() and countSolutions() will
+	 *         then only explore one assignment out of each class of symmetric ones
+	 * \param  values Vector containing the interchangeable values
+	 */
+	void addInterchangeableValues ( std::vector<T> values );
+
+	/**
+	 * \brief  Declare a permutation of the variables as a symmetry of the CSP, i.e.
+	 *         exchanging the values of the variables according to the permutation
+	 *         (e.g. swapping two rows of a grid) maps a solution to another solution.
+	 *         The search will only accept the assignments which are lexicographically
+	 *         not greater than their permuted counterpart (lex-leader constraint)
+	 * \param  permutation Vector whose i-th element is the index of the variable
+	 *         the i-th variable is mapped to
+	 */
+	void addVariableSymmetry ( const std::vector<size_t> &permutation );
+
+	/**
+	 * \brief  Drop all the symmetries declared through addInterchangeableValues() and
+	 *         addVariableSymmetry()
+	 */
+	void clearSymmetries ( void );
+
+	/**
+	 * \brief  Count the solutions of the CSP through an exhaustive search. If some
+	 *         symmetries were declared, only one solution out of each class of
+	 *         symmetric solutions is counted. The variables are left untouched
+	 * \param  limit Stop counting after this number of solutions (0 = no limit)
+	 * \return The number of solutions found
+	 */
+	size_t countSolutions ( size_t limit = 0 );
+
+	/**
+	 * \brief  Periodically save the state of the CSP to a checkpoint file while
+	 *         solve(), optimise() or countSolutions() are running. Each checkpoint
+	 *         atomically replaces the previous one. The values of the variables are
+	 *         saved as raw bytes, so the type T must be trivially copyable
+	 * \param  file Path of the checkpoint file (an empty string disables it)
+	 * \param  every Write a checkpoint every this number of search nodes (solve()
+	 *         writes it at every iteration)
+	 */
+	void setCheckpoint ( const std::string &file, size_t every = 1000 );
+
+	/**
+	 * \brief  Save the current state of the CSP (values, set flags and domains of
+	 *         the variables, and the open choice points if a search is running) to
+	 *         a checkpoint file. The whole state is written each time to a
+	 *         temporary file, then renamed over the previous checkpoint
+	 * \param  file Path of the checkpoint file
+	 */
+	void checkpoint ( const std::string &file );
+
+	/**
+	 * \brief  Restore the state saved in a checkpoint file. The file is mapped in
+	 *         memory, the sizes and offsets of its sections and the indices they
+	 *         hold are checked, and the sections are copied back as they are,
+	 *         without parsing them; the file is unmapped afterwards. The CSP must
+	 *         have been built with the same variables, domains and constraints as
+	 *         the one which wrote the checkpoint. If the file is truncated, corrupt
+	 *         or written by a different CSP, a CSPexception is thrown and the CSP is
+	 *         left unchanged. If the checkpoint was written during a search, the
+	 *         next call to the same search method (optimise() or countSolutions())
+	 *         continues from where it stopped
+	 * \param  file Path of the checkpoint file
+	 */
+	void resume ( const std::string &file );
 };
 
 #endif
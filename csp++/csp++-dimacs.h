@@ -0,0 +1,143 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-dimacs.h
+ *
+ *    Description:  Loader for graphs in DIMACS format (.col files, the format used
+ *                  by the standard graph colouring benchmarks), and construction of
+ *                  the CSP colouring a graph with a given number of colours
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 19:40:12
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_DIMACS_H
+#define __CSPPP_DIMACS_H
+
+#include	<fstream>
+#include	<sstream>
+#include	<string>
+#include	<vector>
+#include	<algorithm>
+#include	"csp++.h"
+
+/**
+ * \struct CSPgraph csp++-dimacs.h
+ * \brief Undirected graph, as read from a DIMACS file
+ */
+struct CSPgraph  {
+	//! Number of vertices, numbered from 0
+	size_t vertices;
+
+	//! Edges of the graph, each one stored once with the smaller vertex first
+	std::vector< std::pair<size_t, size_t> > edges;
+};
+
+/**
+ * \brief  Read a graph in DIMACS format. The file contains a line "p edge <vertices>
+ *         <edges>" (or "p col ...") followed by a line "e <u> <v>" for each edge,
+ *         with the vertices numbered from 1, while lines starting with "c" are
+ *         comments. Loops are ignored, and edges given twice are only kept once.
+ *         The number of edges of the problem line isn't trusted, only the "e"
+ *         lines count
+ * \param  file Path of the file to be read
+ * \return The graph read from the file
+ */
+inline CSPgraph
+readDimacsGraph ( const char *file )
+{
+	CSPgraph g;
+	std::ifstream in(file);
+	std::string line;
+	bool header = false;
+
+	if (!in)
+		throw CSPexception("Unable to read the graph file");
+
+	g.vertices = 0;
+
+	while (getline(in, line))  {
+		std::istringstream ss(line);
+		std::string type;
+
+		if (!(ss >> type) || type == "c")
+			continue;
+
+		if (type == "p")  {
+			std::string format;
+			long long vertices, edges;
+
+			if (!(ss >> format >> vertices >> edges) || vertices < 0 || edges < 0)
+				throw CSPexception("Invalid problem line in the graph file");
+
+			if (format != "edge" && format != "col")
+				throw CSPexception("Unknown problem format in the graph file");
+
+			g.vertices = vertices;
+			header = true;
+		} else if (type == "e")  {
+			size_t u, v;
+
+			if (!header)
+				throw CSPexception("Edge found before the problem line in the graph file");
+
+			if (!(ss >> u >> v) || u < 1 || v < 1 || u > g.vertices || v > g.vertices)
+				throw CSPexception("Invalid edge in the graph file");
+
+			if (u == v)
+				continue;
+
+			if (u > v)
+				std::swap(u, v);
+
+			g.edges.push_back( std::make_pair(u-1, v-1) );
+		}
+	}
+
+	if (!header)
+		throw CSPexception("No problem line in the graph file");
+
+	sort(g.edges.begin(), g.edges.end());
+	g.edges.erase( unique(g.edges.begin(), g.edges.end()), g.edges.end() );
+	return g;
+}
+
+/**
+ * \brief  Build the CSP colouring a graph: a variable for each vertex, whose domain
+ *         contains the colours from 0 to colours-1, and a not-equal constraint for
+ *         each edge. The colours are declared as interchangeable values
+ * \param  g Graph to be coloured
+ * \param  colours Number of colours, at least 1
+ * \return The CSP representing the colouring problem
+ */
+inline CSP<int>
+dimacsColouring ( const CSPgraph &g, int colours )
+{
+	if (colours < 1)
+		throw CSPexception("Invalid number of colours");
+
+	CSP<int> csp(g.vertices);
+	std::vector<int> domain;
+
+	for ( int i=0; i < colours; i++ )
+		domain.push_back(i);
+
+	for ( size_t i=0; i < g.vertices; i++ )
+		csp.setDomain(i, domain);
+
+	for ( size_t i=0; i < g.edges.size(); i++ )
+		csp.appendConstraint(g.edges[i].first, g.edges[i].second, CSP<int>::notEqual);
+
+	csp.addInterchangeableValues(domain);
+	return csp;
+}
+
+#endif
@@ -0,0 +1,458 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-expr.h
+ *
+ *    Description:  Expressions over the variables of a CSP, for writing constraints
+ *                  like x != y, x + y == z or implies(a < b, c == 0) instead of a
+ *                  function. An expression is a tree of templates whose shape is
+ *                  known at compile time: CSP::appendConstraint() picks from its
+ *                  type the propagator to use, and evaluating it is inlined into
+ *                  that propagator. Included by csp++-def.h
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:41:08
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_EXPR_H
+#define __CSPPP_EXPR_H
+
+#include	<vector>
+#include	<utility>
+#include	<stddef.h>
+#include	"csp++-kernels.h"
+
+/**
+ * \class CSPexpression csp++.h
+ * \brief Base of the expressions taking a value of type T, e.g. x + 1
+ */
+template<class T, class E>
+class CSPexpression  {
+public:
+	typedef T value_type;
+
+	//! The expression, with its actual type
+	const E& self ( void ) const  { return static_cast<const E&>(*this); }
+};
+
+/**
+ * \class CSPconstraint csp++.h
+ * \brief Base of the expressions taking a truth value, e.g. x + 1 < y, which can be
+ *        appended to a CSP<T> through CSP::appendConstraint()
+ */
+template<class T, class E>
+class CSPconstraint  {
+public:
+	typedef T value_type;
+
+	//! The expression, with its actual type
+	const E& self ( void ) const  { return static_cast<const E&>(*this); }
+};
+
+// Each node of an expression tells how many variables and constants its leaves
+// hold, so the leaves are numbered at compile time, from left to right. The
+// variables are stored in the CSP as a list of indexes and the constants as a
+// list of values, and eval<V, C>() reads the ones of the node starting from the
+// V-th value and the C-th constant. A node is linear if it is a sum of variables
+// multiplied by constants, and terms() then adds its variables multiplied by
+// factor to a list, and its constant part to constant
+
+template<bool B>
+struct __csp_flag  {};
+
+/**
+ * \class CSPvar csp++.h
+ * \brief Handle of a variable of a CSP, to be used in expressions
+ */
+template<class T>
+class CSPvar : public CSPexpression< T, CSPvar<T> >  {
+public:
+	enum  { variables = 1, constants = 0, linear = 1 };
+
+	//! Index of the variable
+	size_t index;
+
+	/**
+	 * \brief Constructor
+	 * \param i Index of the variable in the CSP
+	 */
+	explicit CSPvar ( size_t i ) : index(i)  {}
+
+	void collect ( std::vector<size_t> &vars, std::vector<T>& ) const  { vars.push_back(index); }
+
+	void terms ( std::vector< std::pair<size_t, T> > &list, T&, const T &factor ) const
+	{
+		list.push_back( std::make_pair(index, factor) );
+	}
+
+	template<size_t V, size_t C>
+	static T eval ( const T *x, const T* )  { return x[V]; }
+};
+
+template<class T>
+class __csp_const : public CSPexpression< T, __csp_const<T> >  {
+public:
+	enum  { variables = 0, constants = 1, linear = 1 };
+	T value;
+
+	__csp_const ( const T &v ) : value(v)  {}
+
+	void collect ( std::vector<size_t>&, std::vector<T> &consts ) const  { consts.push_back(value); }
+
+	void terms ( std::vector< std::pair<size_t, T> >&, T &constant, const T &factor ) const
+	{
+		constant += factor * value;
+	}
+
+	template<size_t V, size_t C>
+	static T eval ( const T*, const T *k )  { return k[C]; }
+};
+
+struct __csp_plus  {
+	enum  { additive = 1 };
+	template<class T> static T apply ( const T &a, const T &b )  { return a + b; }
+};
+
+struct __csp_minus  {
+	enum  { additive = 1 };
+	template<class T> static T apply ( const T &a, const T &b )  { return a - b; }
+};
+
+struct __csp_times  {
+	enum  { additive = 0 };
+	template<class T> static T apply ( const T &a, const T &b )  { return a * b; }
+};
+
+template<class T, class Op, class L, class R>
+class __csp_arith : public CSPexpression< T, __csp_arith<T, Op, L, R> >  {
+public:
+	enum  {
+		variables = L::variables + R::variables,
+		constants = L::constants + R::constants,
+
+		// A product is linear only if one of its factors is a constant
+		linear = L::linear && R::linear && (Op::additive || L::variables == 0 || R::variables == 0)
+	};
+
+	L l;
+	R r;
+
+	__csp_arith ( const L &a, const R &b ) : l(a), r(b)  {}
+
+	void collect ( std::vector<size_t> &vars, std::vector<T> &consts ) const
+	{
+		l.collect(vars, consts);
+		r.collect(vars, consts);
+	}
+
+	void terms ( std::vector< std::pair<size_t, T> > &list, T &constant, const T &factor ) const
+	{
+		__terms(list, constant, factor, Op());
+	}
+
+	template<size_t V, size_t C>
+	static T eval ( const T *x, const T *k )
+	{
+		return Op::apply(L::template eval<V, C>(x, k),
+				R::template eval<V + L::variables, C + L::constants>(x, k));
+	}
+
+private:
+	void __terms ( std::vector< std::pair<size_t, T> > &list, T &constant, const T &factor,
+			__csp_plus ) const
+	{
+		l.terms(list, constant, factor);
+		r.terms(list, constant, factor);
+	}
+
+	void __terms ( std::vector< std::pair<size_t, T> > &list, T &constant, const T &factor,
+			__csp_minus ) const
+	{
+		l.terms(list, constant, factor);
+		r.terms(list, constant, -factor);
+	}
+
+	void __terms ( std::vector< std::pair<size_t, T> > &list, T &constant, const T &factor,
+			__csp_times ) const
+	{
+		// The factor without variables is a constant, found as its own constant part
+		T value = T();
+
+		if (L::variables)  {
+			r.terms(list, value, T(1));
+			l.terms(list, constant, factor * value);
+		} else {
+			l.terms(list, value, T(1));
+			r.terms(list, constant, factor * value);
+		}
+	}
+};
+
+// Relations between two values. Between two variables, a relation is propagated
+// on whole domains: cmp is the comparison a value of the first variable must pass
+// against the largest (upper) or smallest value of the other domain, converse the
+// one a value of the second variable must pass against the opposite bound.
+// Between two linear expressions, l - r is computed, and feasible() tells whether
+// a value between lo and hi may be in the relation with 0. A relation on bounds
+// can only lose its support when the bounds of a domain change, the other ones
+// when a domain is reduced to a single value
+
+struct __csp_eq  {
+	enum  { bounds = 1 };
+	template<class T> static bool test ( const T &a, const T &b )  { return a == b; }
+	template<class T> static bool feasible ( const T &lo, const T &hi )  { return !(0 < lo) && !(hi < 0); }
+};
+
+struct __csp_ne  {
+	enum  { bounds = 0 };
+	template<class T> static bool test ( const T &a, const T &b )  { return !(a == b); }
+	template<class T> static bool feasible ( const T &lo, const T &hi )  { return !(lo == 0 && hi == 0); }
+};
+
+struct __csp_lt  {
+	enum  { bounds = 1, upper = 1 };
+	static const __csp_cmp cmp = __CSP_LT, converse = __CSP_GT;
+	template<class T> static bool test ( const T &a, const T &b )  { return a < b; }
+	template<class T> static bool feasible ( const T &lo, const T& )  { return lo < 0; }
+};
+
+struct __csp_le  {
+	enum  { bounds = 1, upper = 1 };
+	static const __csp_cmp cmp = __CSP_LE, converse = __CSP_GE;
+	template<class T> static bool test ( const T &a, const T &b )  { return !(b < a); }
+	template<class T> static bool feasible ( const T &lo, const T& )  { return !(0 < lo); }
+};
+
+struct __csp_gt  {
+	enum  { bounds = 1, upper = 0 };
+	static const __csp_cmp cmp = __CSP_GT, converse = __CSP_LT;
+	template<class T> static bool test ( const T &a, const T &b )  { return b < a; }
+	template<class T> static bool feasible ( const T&, const T &hi )  { return 0 < hi; }
+};
+
+struct __csp_ge  {
+	enum  { bounds = 1, upper = 0 };
+	static const __csp_cmp cmp = __CSP_GE, converse = __CSP_LE;
+	template<class T> static bool test ( const T &a, const T &b )  { return !(a < b); }
+	template<class T> static bool feasible ( const T&, const T &hi )  { return !(hi < 0); }
+};
+
+template<class T, class Op, class L, class R>
+class __csp_relation : public CSPconstraint< T, __csp_relation<T, Op, L, R> >  {
+public:
+	enum  {
+		variables = L::variables + R::variables,
+		constants = L::constants + R::constants,
+		linear = L::linear && R::linear
+	};
+
+	L l;
+	R r;
+
+	__csp_relation ( const L &a, const R &b ) : l(a), r(b)  {}
+
+	void collect ( std::vector<size_t> &vars, std::vector<T> &consts ) const
+	{
+		l.collect(vars, consts);
+		r.collect(vars, consts);
+	}
+
+	template<size_t V, size_t C>
+	static bool eval ( const T *x, const T *k )
+	{
+		return Op::test(L::template eval<V, C>(x, k),
+				R::template eval<V + L::variables, C + L::constants>(x, k));
+	}
+};
+
+struct __csp_and  {
+	static bool test ( bool a, bool b )  { return a && b; }
+};
+
+struct __csp_or  {
+	static bool test ( bool a, bool b )  { return a || b; }
+};
+
+struct __csp_implies  {
+	static bool test ( bool a, bool b )  { return !a || b; }
+};
+
+template<class T, class Op, class L, class R>
+class __csp_logic : public CSPconstraint< T, __csp_logic<T, Op, L, R> >  {
+public:
+	enum  {
+		variables = L::variables + R::variables,
+		constants = L::constants + R::constants,
+		linear = 0
+	};
+
+	L l;
+	R r;
+
+	__csp_logic ( const L &a, const R &b ) : l(a), r(b)  {}
+
+	void collect ( std::vector<size_t> &vars, std::vector<T> &consts ) const
+	{
+		l.collect(vars, consts);
+		r.collect(vars, consts);
+	}
+
+	template<size_t V, size_t C>
+	static bool eval ( const T *x, const T *k )
+	{
+		return Op::test(L::template eval<V, C>(x, k),
+				R::template eval<V + L::variables, C + L::constants>(x, k));
+	}
+};
+
+template<class T, class E>
+class __csp_not : public CSPconstraint< T, __csp_not<T, E> >  {
+public:
+	enum  { variables = E::variables, constants = E::constants, linear = 0 };
+	E e;
+
+	__csp_not ( const E &a ) : e(a)  {}
+
+	void collect ( std::vector<size_t> &vars, std::vector<T> &consts ) const  { e.collect(vars, consts); }
+
+	template<size_t V, size_t C>
+	static bool eval ( const T *x, const T *k )  { return !E::template eval<V, C>(x, k); }
+};
+
+/**
+ * \class CSPallDifferent csp++.h
+ * \brief Constraint requiring a list of variables to take different values. It
+ *        isn't an expression, but it can be appended to a CSP<T> like them, and
+ *        it is propagated by a single propagator instead of one for each pair
+ */
+template<class T>
+class CSPallDifferent  {
+public:
+	//! Indexes of the variables
+	std::vector<size_t> scope;
+
+	/**
+	 * \brief Constructor
+	 * \param s Indexes of the variables
+	 */
+	explicit CSPallDifferent ( const std::vector<size_t> &s ) : scope(s)  {}
+};
+
+// An operator between two expressions, or between an expression and a constant
+// on either side. The constant is in a non-deduced context, so it is converted
+// to the type of the values of the expression
+#define	__CSP_OPERATOR(op, Node, Base, Op) \
+	template<class T, class L, class R> \
+	inline Node<T, Op, L, R> \
+	operator op ( const Base<T, L> &l, const Base<T, R> &r ) \
+	{ \
+		return Node<T, Op, L, R>(l.self(), r.self()); \
+	} \
+	\
+	template<class T, class L> \
+	inline Node<T, Op, L, __csp_const<T> > \
+	operator op ( const Base<T, L> &l, const typename Base<T, L>::value_type &r ) \
+	{ \
+		return Node<T, Op, L, __csp_const<T> >(l.self(), __csp_const<T>(r)); \
+	} \
+	\
+	template<class T, class R> \
+	inline Node<T, Op, __csp_const<T>, R> \
+	operator op ( const typename Base<T, R>::value_type &l, const Base<T, R> &r ) \
+	{ \
+		return Node<T, Op, __csp_const<T>, R>(__csp_const<T>(l), r.self()); \
+	}
+
+__CSP_OPERATOR(+, __csp_arith, CSPexpression, __csp_plus)
+__CSP_OPERATOR(-, __csp_arith, CSPexpression, __csp_minus)
+__CSP_OPERATOR(*, __csp_arith, CSPexpression, __csp_times)
+__CSP_OPERATOR(==, __csp_relation, CSPexpression, __csp_eq)
+__CSP_OPERATOR(!=, __csp_relation, CSPexpression, __csp_ne)
+__CSP_OPERATOR(<, __csp_relation, CSPexpression, __csp_lt)
+__CSP_OPERATOR(<=, __csp_relation, CSPexpression, __csp_le)
+__CSP_OPERATOR(>, __csp_relation, CSPexpression, __csp_gt)
+__CSP_OPERATOR(>=, __csp_relation, CSPexpression, __csp_ge)
+
+#undef	__CSP_OPERATOR
+
+/**
+ * \brief Conjunction of two constraints, kept as a single constraint. Appending the
+ *        two constraints separately propagates them better
+ */
+template<class T, class L, class R>
+inline __csp_logic<T, __csp_and, L, R>
+operator&& ( const CSPconstraint<T, L> &l, const CSPconstraint<T, R> &r )
+{
+	return __csp_logic<T, __csp_and, L, R>(l.self(), r.self());
+}
+
+/**
+ * \brief Disjunction of two constraints
+ */
+template<class T, class L, class R>
+inline __csp_logic<T, __csp_or, L, R>
+operator|| ( const CSPconstraint<T, L> &l, const CSPconstraint<T, R> &r )
+{
+	return __csp_logic<T, __csp_or, L, R>(l.self(), r.self());
+}
+
+/**
+ * \brief Negation of a constraint
+ */
+template<class T, class E>
+inline __csp_not<T, E>
+operator! ( const CSPconstraint<T, E> &e )
+{
+	return __csp_not<T, E>(e.self());
+}
+
+/**
+ * \brief  Constraint holding when a does not hold or b holds
+ * \param  a Condition
+ * \param  b Constraint required when a holds
+ */
+template<class T, class L, class R>
+inline __csp_logic<T, __csp_implies, L, R>
+implies ( const CSPconstraint<T, L> &a, const CSPconstraint<T, R> &b )
+{
+	return __csp_logic<T, __csp_implies, L, R>(a.self(), b.self());
+}
+
+/**
+ * \brief  Constraint requiring the given variables to take different values
+ * \param  vars Handles of the variables
+ */
+template<class T>
+inline CSPallDifferent<T>
+allDifferent ( const std::vector< CSPvar<T> > &vars )
+{
+	std::vector<size_t> scope(vars.size());
+
+	for ( size_t i=0; i < vars.size(); i++ )
+		scope[i] = vars[i].index;
+
+	return CSPallDifferent<T>(scope);
+}
+
+/**
+ * \brief  Constraint requiring the given variables to take different values, e.g.
+ *         allDifferent<int>(row)
+ * \param  scope Indexes of the variables
+ */
+template<class T>
+inline CSPallDifferent<T>
+allDifferent ( const std::vector<size_t> &scope )
+{
+	return CSPallDifferent<T>(scope);
+}
+
+#endif
+
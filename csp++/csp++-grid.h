@@ -0,0 +1,299 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-grid.h
+ *
+ *    Description:  Grid puzzles made of rows, columns and boxes whose cells must all
+ *                  take different values, like the sudoku of any size. The units
+ *                  (rows, columns and boxes) and the peers of each cell are computed
+ *                  once, when the grid is built, and the CSP of a puzzle holds an
+ *                  allDifferent constraint for each unit, which removes the values
+ *                  of the set cells from their peers (naked singles) and sets the
+ *                  cells holding the only place left for a value in a unit (hidden
+ *                  singles)
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 14:36:08
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_GRID_H
+#define __CSPPP_GRID_H
+
+#include	<fstream>
+#include	<ostream>
+#include	<string>
+#include	<vector>
+#include	<cstdlib>
+#include	<algorithm>
+#include	"csp++.h"
+
+/**
+ * \class CSPgrid csp++-grid.h
+ * \brief Square grid of side box_rows*box_cols, split into boxes of box_rows rows
+ *        and box_cols columns, whose rows, columns and boxes (the units) must hold
+ *        the values from 1 to the side once each. The cells are numbered row by
+ *        row from 0, and so are the variables of the CSP returned by model()
+ */
+class CSPgrid  {
+	size_t __box_rows;
+	size_t __box_cols;
+	size_t __side;
+
+	// The rows, then the columns, then the boxes, each one as a list of cells
+	std::vector< std::vector<size_t> > __units;
+
+	// The cells sharing a unit with each cell, sorted
+	std::vector< std::vector<size_t> > __peers;
+
+	void __build ( void )
+	{
+		size_t cells = __side * __side;
+
+		if (__box_rows == 0 || __box_cols == 0)
+			throw CSPexception("The boxes of the grid are empty");
+
+		__units.assign(3 * __side, std::vector<size_t>());
+		__peers.assign(cells, std::vector<size_t>());
+
+		for ( size_t c=0; c < cells; c++ )  {
+			__units[row(c)].push_back(c);
+			__units[__side + column(c)].push_back(c);
+			__units[2*__side + box(c)].push_back(c);
+		}
+
+		for ( size_t u=0; u < __units.size(); u++ )  {
+			for ( size_t i=0; i < __side; i++ )  {
+				for ( size_t j=0; j < __side; j++ )  {
+					if (i != j)
+						__peers[__units[u][i]].push_back(__units[u][j]);
+				}
+			}
+		}
+
+		for ( size_t c=0; c < cells; c++ )  {
+			std::sort(__peers[c].begin(), __peers[c].end());
+			__peers[c].erase( std::unique(__peers[c].begin(), __peers[c].end()), __peers[c].end() );
+		}
+	}
+
+public:
+	/**
+	 * \brief  Constructor of a grid with square boxes, e.g. CSPgrid(3) for the
+	 *         usual 9x9 sudoku
+	 * \param  n Number of rows and columns of each box
+	 */
+	explicit CSPgrid ( size_t n = 3 ) : __box_rows(n), __box_cols(n), __side(n*n)
+	{
+		__build();
+	}
+
+	/**
+	 * \brief  Constructor of a grid with rectangular boxes, e.g. CSPgrid(2, 3) for a
+	 *         6x6 sudoku
+	 * \param  box_rows Number of rows of each box
+	 * \param  box_cols Number of columns of each box
+	 */
+	CSPgrid ( size_t box_rows, size_t box_cols ) :
+		__box_rows(box_rows), __box_cols(box_cols), __side(box_rows*box_cols)
+	{
+		__build();
+	}
+
+	/**
+	 * \brief  Number of rows and columns of the grid, i.e. of values of each cell
+	 */
+	size_t side ( void ) const  { return __side; }
+
+	/**
+	 * \brief  Number of rows of each box
+	 */
+	size_t boxRows ( void ) const  { return __box_rows; }
+
+	/**
+	 * \brief  Number of columns of each box
+	 */
+	size_t boxColumns ( void ) const  { return __box_cols; }
+
+	/**
+	 * \brief  Number of cells of the grid
+	 */
+	size_t cells ( void ) const  { return __side * __side; }
+
+	/**
+	 * \brief  Index of a cell
+	 * \param  r Row of the cell, from 0
+	 * \param  c Column of the cell, from 0
+	 */
+	size_t cell ( size_t r, size_t c ) const  { return r*__side + c; }
+
+	/**
+	 * \brief  Row of a cell, from 0
+	 */
+	size_t row ( size_t cell ) const  { return cell / __side; }
+
+	/**
+	 * \brief  Column of a cell, from 0
+	 */
+	size_t column ( size_t cell ) const  { return cell % __side; }
+
+	/**
+	 * \brief  Box of a cell, numbered row by row from 0
+	 */
+	size_t box ( size_t cell ) const
+	{
+		return (row(cell) / __box_rows) * __box_rows + column(cell) / __box_cols;
+	}
+
+	/**
+	 * \brief  The units of the grid: the side rows, then the side columns, then the
+	 *         side boxes, each one as the list of its cells
+	 */
+	const std::vector< std::vector<size_t> >& units ( void ) const  { return __units; }
+
+	/**
+	 * \brief  The cells sharing a row, a column or a box with a cell, sorted
+	 * \param  cell Index of the cell
+	 */
+	const std::vector<size_t>& peers ( size_t cell ) const  { return __peers[cell]; }
+
+	/**
+	 * \brief  Build the CSP of a puzzle on the grid: a variable for each cell, whose
+	 *         domain holds the values from 1 to side(), and an allDifferent
+	 *         constraint for each unit
+	 * \param  givens Values of the cells, row by row, 0 for the empty cells. If
+	 *           empty, no cell is set
+	 * \return The CSP of the puzzle
+	 */
+	CSP<int> model ( const std::vector<int> &givens = std::vector<int>() ) const
+	{
+		if (!givens.empty() && givens.size() != cells())
+			throw CSPexception("The number of values doesn't match the cells of the grid");
+
+		CSP<int> csp(cells());
+		std::vector<int> domain;
+
+		for ( size_t v=1; v <= __side; v++ )
+			domain.push_back((int) v);
+
+		for ( size_t c=0; c < cells(); c++ )
+			csp.setDomain(c, domain);
+
+		for ( size_t u=0; u < __units.size(); u++ )
+			csp.appendConstraint(allDifferent<int>(__units[u]));
+
+		for ( size_t c=0; c < givens.size(); c++ )  {
+			if (givens[c] < 0 || (size_t) givens[c] > __side)
+				throw CSPexception("Invalid value in the grid");
+
+			if (givens[c])
+				csp.setValue(c, givens[c]);
+		}
+
+		return csp;
+	}
+
+	/**
+	 * \brief  Print the cells of a puzzle on the grid, with a blank line between the
+	 *         rows of boxes and a wider space between the columns of boxes, and a
+	 *         dot for the cells not set
+	 * \param  out Output stream
+	 * \param  csp CSP of the puzzle, as built by model()
+	 */
+	void print ( std::ostream &out, const CSP<int> &csp ) const
+	{
+		for ( size_t r=0; r < __side; r++ )  {
+			if (!(r % __box_rows))
+				out << std::endl;
+
+			for ( size_t c=0; c < __side; c++ )  {
+				if (!(c % __box_cols))
+					out << "  ";
+
+				if (csp.isSet(cell(r, c)))
+					out << csp.value(cell(r, c)) << " ";
+				else
+					out << ". ";
+			}
+
+			out << std::endl;
+		}
+
+		out << std::endl;
+	}
+};
+
+/**
+ * \brief  Read a puzzle from a text file holding a line for each row of the grid,
+ *         with the values of the cells separated by any character but the digits
+ *         (0 for the empty cells). The lines without digits (e.g. the comments and
+ *         the borders of the boxes) are skipped. The boxes are taken as tall as
+ *         the largest divisor of the side not greater than its square root, and as
+ *         wide as needed
+ * \param  file Path of the file to be read
+ * \param  givens Filled with the values of the cells, row by row
+ * \return The grid of the puzzle
+ */
+inline CSPgrid
+readGrid ( const char *file, std::vector<int> &givens )
+{
+	std::ifstream in(file);
+	std::string line;
+	size_t side = 0;
+	size_t rows = 0;
+
+	if (!in)
+		throw CSPexception("Unable to read input file");
+
+	givens.clear();
+
+	while (getline(in, line))  {
+		std::vector<int> values;
+		std::string value;
+
+		for ( size_t j=0; j <= line.length(); j++ )  {
+			if (j < line.length() && line[j] >= '0' && line[j] <= '9')  {
+				value += line[j];
+			} else if (value.length() > 0)  {
+				values.push_back( atoi(value.c_str()) );
+				value = "";
+			}
+		}
+
+		if (values.empty())
+			continue;
+
+		if (rows == 0)
+			side = values.size();
+		else if (values.size() != side)
+			throw CSPexception("The columns have different number of elements");
+
+		givens.insert(givens.end(), values.begin(), values.end());
+		rows++;
+	}
+
+	if (rows == 0)
+		throw CSPexception("The grid is empty");
+
+	if (rows != side)
+		throw CSPexception("The grid is not a square");
+
+	size_t box_rows = 1;
+
+	for ( size_t r=2; r*r <= side; r++ )  {
+		if (side % r == 0)
+			box_rows = r;
+	}
+
+	return CSPgrid(box_rows, side / box_rows);
+}
+
+#endif
+
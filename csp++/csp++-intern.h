@@ -0,0 +1,264 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-intern.h
+ *
+ *    Description:  Interning of the values of a CSP whose values are expensive to
+ *                  copy and compare, e.g. std::string labels or small structs. Each
+ *                  value is mapped once to a dense integer id, and the CSP is built
+ *                  over the ids: the domains, the propagation and the search only
+ *                  copy and compare ints (using the kernels for int), while the
+ *                  values are translated back only when they are read
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 10:12:47
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_INTERN_H
+#define __CSPPP_INTERN_H
+
+#include	<map>
+#include	<vector>
+#include	<algorithm>
+#include	"csp++.h"
+
+/**
+ * \class CSPdictionary csp++-intern.h
+ * \brief Bijection between some values of type T and the ids 0, 1, 2, ... The ids
+ *        are given in the order the values are interned, so they compare like
+ *        the values if these are interned in increasing order
+ */
+template<class T>
+class CSPdictionary  {
+	std::map<T, int> __ids;
+
+	// The values are stored once, as the keys of the map, whose nodes never move
+	std::vector<const T*> __values;
+
+public:
+	/**
+	 * \brief  Id of a value, which is interned if it wasn't yet
+	 * \param  value Value
+	 * \return The id of the value
+	 */
+	int intern ( const T &value )
+	{
+		typename std::map<T, int>::iterator it = __ids.lower_bound(value);
+
+		if (it == __ids.end() || __ids.key_comp()(value, it->first))  {
+			it = __ids.insert(it, std::make_pair(value, (int) __values.size()));
+			__values.push_back(&it->first);
+		}
+
+		return it->second;
+	}
+
+	/**
+	 * \brief  Ids of a list of values, which are interned if they weren't yet
+	 * \param  values Values
+	 * \return The ids of the values, in the same order
+	 */
+	std::vector<int> intern ( const std::vector<T> &values )
+	{
+		std::vector<int> ids(values.size());
+
+		for ( size_t i=0; i < values.size(); i++ )
+			ids[i] = intern(values[i]);
+
+		return ids;
+	}
+
+	/**
+	 * \brief  Id of a value already interned
+	 * \param  value Value
+	 * \return The id of the value. An exception is thrown if the value was never
+	 *         interned
+	 */
+	int id ( const T &value ) const
+	{
+		typename std::map<T, int>::const_iterator it = __ids.find(value);
+
+		if (it == __ids.end())
+			throw CSPexception("Unknown value");
+
+		return it->second;
+	}
+
+	/**
+	 * \brief  Value with a given id
+	 * \param  id Id returned by intern()
+	 * \return Reference to the value, valid as long as the dictionary
+	 */
+	const T& value ( int id ) const
+	{
+		if (id < 0 || (size_t) id >= __values.size())
+			throw CSPexception("Invalid id");
+
+		return *__values[id];
+	}
+
+	/**
+	 * \brief  Values with the given ids
+	 * \param  ids Ids returned by intern()
+	 * \return The values, in the same order
+	 */
+	std::vector<T> values ( CSPspan<int> ids ) const
+	{
+		std::vector<T> values;
+		values.reserve(ids.size());
+
+		for ( size_t i=0; i < ids.size(); i++ )
+			values.push_back(value(ids[i]));
+
+		return values;
+	}
+
+	/**
+	 * \brief  Number of values interned
+	 */
+	size_t size ( void ) const  { return __values.size(); }
+};
+
+/**
+ * \class CSPinterned csp++-intern.h
+ * \brief CSP whose values of type T are stored and compared through their ids in a
+ *        CSPdictionary. The domains and the values of the variables are read and
+ *        written as values of type T, while everything else is done on the
+ *        underlying CSP<int>, returned by csp(): the constraints are written
+ *        over the ids. CSP<int>::notEqual and CSP<int>::equal hold between two
+ *        ids exactly when they hold between their values, and so does
+ *        CSP<int>::lessThan if the values are given to the constructor. In that
+ *        case the set of values is closed: a value that wasn't given to the
+ *        constructor would get an id out of order, so id(), setDomain() and
+ *        setValue() throw a CSPexception instead of interning it
+ */
+template<class T>
+class CSPinterned  {
+	CSPdictionary<T> __dictionary;
+	CSP<int> __csp;
+
+	// True if the values were given to the constructor, and their ids are ordered
+	bool __ordered;
+
+	int __intern ( const T &value )
+	{
+		if (!__ordered)
+			return __dictionary.intern(value);
+
+		try  {
+			return __dictionary.id(value);
+		} catch (const CSPexception&)  {
+			throw CSPexception("Value not given to the constructor of an ordered CSPinterned");
+		}
+	}
+
+	std::vector<int> __intern ( const std::vector<T> &values )
+	{
+		std::vector<int> ids(values.size());
+
+		for ( size_t i=0; i < values.size(); i++ )
+			ids[i] = __intern(values[i]);
+
+		return ids;
+	}
+
+public:
+	/**
+	 * \brief  Constructor
+	 * \param  n Number of variables
+	 * \param  values Values interned in increasing order, so that their ids
+	 *           compare like them. If some are given, no other value can be used
+	 */
+	CSPinterned ( int n, const std::vector<T> &values = std::vector<T>() ) : __csp(n), __ordered(!values.empty())
+	{
+		std::vector<T> sorted(values);
+
+		std::sort(sorted.begin(), sorted.end());
+
+		for ( size_t i=0; i < sorted.size(); i++ )
+			__dictionary.intern(sorted[i]);
+	}
+
+	/**
+	 * \brief  The CSP over the ids, for appending the constraints, solving it and
+	 *         reading its state
+	 */
+	CSP<int>& csp ( void )  { return __csp; }
+
+	/**
+	 * \brief  The CSP over the ids
+	 */
+	const CSP<int>& csp ( void ) const  { return __csp; }
+
+	/**
+	 * \brief  The dictionary of the values
+	 */
+	CSPdictionary<T>& dictionary ( void )  { return __dictionary; }
+
+	/**
+	 * \brief  The dictionary of the values
+	 */
+	const CSPdictionary<T>& dictionary ( void ) const  { return __dictionary; }
+
+	/**
+	 * \brief  Id of a value, e.g. for building the constraints
+	 * \param  value Value, interned if it wasn't yet and the CSP isn't ordered
+	 */
+	int id ( const T &value )  { return __intern(value); }
+
+	/**
+	 * \brief  Number of variables
+	 */
+	size_t size ( void ) const  { return __csp.size(); }
+
+	/**
+	 * \brief  Set the domain of a variable, interning its values
+	 * \param  index Index of the variable
+	 * \param  domain Values the variable can take
+	 */
+	void setDomain ( size_t index, const std::vector<T> &domain )
+	{
+		__csp.setDomain(index, __intern(domain));
+	}
+
+	/**
+	 * \brief  Current domain of a variable
+	 * \param  index Index of the variable
+	 * \return Copy of the values left in the domain
+	 */
+	std::vector<T> domain ( size_t index ) const
+	{
+		return __dictionary.values(__csp.domainSpan(index));
+	}
+
+	/**
+	 * \brief  Set the value of a variable
+	 * \param  index Index of the variable
+	 * \param  value Value, interned if it wasn't yet and the CSP isn't ordered
+	 */
+	void setValue ( size_t index, const T &value )
+	{
+		__csp.setValue(index, __intern(value));
+	}
+
+	/**
+	 * \brief  Value of a variable
+	 * \param  index Index of the variable
+	 * \return Reference to the value, valid as long as the dictionary
+	 */
+	const T& value ( size_t index ) const
+	{
+		return __dictionary.value(__csp.value(index));
+	}
+};
+
+#endif
+
@@ -0,0 +1,238 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-kernels.h
+ *
+ *    Description:  Kernels used by the built-in constraints between two variables for
+ *                  checking a whole domain at once. Each kernel compares an array of
+ *                  values against a single value and writes a mask of bytes (1 if
+ *                  the comparison holds, 0 otherwise). The generic versions are plain
+ *                  loops, while the ones for int use SSE2 on 16 values at a time
+ *                  when it is available. Included by csp++.cpp
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 21:05:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_KERNELS_H
+#define __CSPPP_KERNELS_H
+
+#include	<stddef.h>
+
+#ifdef __SSE2__
+#include	<emmintrin.h>
+#endif
+
+/**
+ * \brief Comparisons computed by the kernels
+ */
+typedef enum  {
+	__CSP_EQ,
+	__CSP_NE,
+	__CSP_LT,
+	__CSP_GT,
+	__CSP_LE,
+	__CSP_GE
+} __csp_cmp;
+
+/**
+ * \brief  Compare each value with b, mask[i] = (values[i] op b)
+ * \param  values Array of values
+ * \param  n Number of values
+ * \param  b Value compared with each one of the array
+ * \param  op Comparison
+ * \param  mask Output array of n bytes
+ */
+template<class T>
+inline void
+__csp_mask ( const T *values, size_t n, const T &b, __csp_cmp op, char *mask )
+{
+	switch (op)  {
+		case __CSP_EQ:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = (values[i] == b);
+			break;
+
+		case __CSP_NE:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = !(values[i] == b);
+			break;
+
+		case __CSP_LT:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = (values[i] < b);
+			break;
+
+		case __CSP_GT:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = (b < values[i]);
+			break;
+
+		case __CSP_LE:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = !(b < values[i]);
+			break;
+
+		case __CSP_GE:
+			for ( size_t i=0; i < n; i++ )
+				mask[i] = !(values[i] < b);
+			break;
+	}
+}
+
+/**
+ * \brief  Same as __csp_mask(), but or'ing the result into the mask
+ */
+template<class T>
+inline void
+__csp_mask_or ( const T *values, size_t n, const T &b, char *mask )
+{
+	for ( size_t i=0; i < n; i++ )
+		mask[i] |= (values[i] == b);
+}
+
+/**
+ * \brief  Smallest and largest value of a non-empty array
+ */
+template<class T>
+inline void
+__csp_minmax ( const T *values, size_t n, T &lo, T &hi )
+{
+	lo = hi = values[0];
+
+	for ( size_t i=1; i < n; i++ )  {
+		if (values[i] < lo)
+			lo = values[i];
+
+		if (hi < values[i])
+			hi = values[i];
+	}
+}
+
+#ifdef __SSE2__
+
+/**
+ * \brief  Compare 4 ints with b. For not-equal, less-or-equal and greater-or-equal
+ *         the result is the complement of the comparison
+ */
+static inline __m128i
+__csp_cmp4 ( __m128i v, __m128i b, __csp_cmp op )
+{
+	switch (op)  {
+		case __CSP_LT:
+		case __CSP_GE:
+			return _mm_cmplt_epi32(v, b);
+
+		case __CSP_GT:
+		case __CSP_LE:
+			return _mm_cmpgt_epi32(v, b);
+
+		default:
+			return _mm_cmpeq_epi32(v, b);
+	}
+}
+
+/**
+ * \brief  Compare 16 ints with b, packing the results into 16 bytes of 0x00 or 0xff
+ */
+static inline __m128i
+__csp_cmp16 ( const int *values, __m128i b, __csp_cmp op )
+{
+	__m128i r0 = __csp_cmp4(_mm_loadu_si128((const __m128i*) values), b, op);
+	__m128i r1 = __csp_cmp4(_mm_loadu_si128((const __m128i*) (values + 4)), b, op);
+	__m128i r2 = __csp_cmp4(_mm_loadu_si128((const __m128i*) (values + 8)), b, op);
+	__m128i r3 = __csp_cmp4(_mm_loadu_si128((const __m128i*) (values + 12)), b, op);
+
+	return _mm_packs_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+}
+
+inline void
+__csp_mask ( const int *values, size_t n, const int &b, __csp_cmp op, char *mask )
+{
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i vb = _mm_set1_epi32(b);
+	size_t i = 0;
+
+	for ( ; i + 16 <= n; i += 16 )  {
+		__m128i r = __csp_cmp16(values + i, vb, op);
+
+		// Not-equal, less-or-equal and greater-or-equal are the complements
+		// of equal, greater-than and less-than
+		bool complement = (op == __CSP_NE || op == __CSP_LE || op == __CSP_GE);
+		r = complement ? _mm_andnot_si128(r, one) : _mm_and_si128(r, one);
+		_mm_storeu_si128((__m128i*) (mask + i), r);
+	}
+
+	__csp_mask<int>(values + i, n - i, b, op, mask + i);
+}
+
+inline void
+__csp_mask_or ( const int *values, size_t n, const int &b, char *mask )
+{
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i vb = _mm_set1_epi32(b);
+	size_t i = 0;
+
+	for ( ; i + 16 <= n; i += 16 )  {
+		__m128i r = _mm_and_si128(__csp_cmp16(values + i, vb, __CSP_EQ), one);
+		__m128i m = _mm_loadu_si128((const __m128i*) (mask + i));
+		_mm_storeu_si128((__m128i*) (mask + i), _mm_or_si128(m, r));
+	}
+
+	__csp_mask_or<int>(values + i, n - i, b, mask + i);
+}
+
+inline void
+__csp_minmax ( const int *values, size_t n, int &lo, int &hi )
+{
+	size_t i = 0;
+
+	if (n >= 4)  {
+		// SSE2 has no min/max on 32 bit integers, so they are selected
+		// through the masks of the comparisons
+		__m128i vlo = _mm_loadu_si128((const __m128i*) values);
+		__m128i vhi = vlo;
+		int l[4], h[4];
+
+		for ( i=4; i + 4 <= n; i += 4 )  {
+			__m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+			__m128i lt = _mm_cmplt_epi32(v, vlo);
+			__m128i gt = _mm_cmpgt_epi32(v, vhi);
+
+			vlo = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vlo));
+			vhi = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vhi));
+		}
+
+		_mm_storeu_si128((__m128i*) l, vlo);
+		_mm_storeu_si128((__m128i*) h, vhi);
+		__csp_minmax<int>(l, 4, lo, hi);
+
+		int lo2, hi2;
+		__csp_minmax<int>(h, 4, lo2, hi2);
+		hi = hi2;
+	} else {
+		lo = hi = values[0];
+		i = 1;
+	}
+
+	for ( ; i < n; i++ )  {
+		if (values[i] < lo)
+			lo = values[i];
+
+		if (hi < values[i])
+			hi = values[i];
+	}
+}
+
+#endif
+
+#endif
+
@@ -0,0 +1,199 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-table.h
+ *
+ *    Description:  Transposition table of the propagation: the Zobrist keys hashing
+ *                  the state of the domains of a CSP, and a bounded table mapping
+ *                  the hash of the state a propagation started from to its result,
+ *                  shared by the CSPs copied from the same one, possibly on several
+ *                  threads. Included by csp++-def.h
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 17:02:33
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_TABLE_H
+#define __CSPPP_TABLE_H
+
+#include	<vector>
+#include	<stdint.h>
+#include	<pthread.h>
+
+#define 	__CSP_TABLE_LOCKS 	64
+
+/**
+ * \brief  Zobrist key of a pair of numbers, e.g. a variable and the position of a
+ *         value in its domain. The keys are pseudo-random, so the XOR of the keys
+ *         of a set of pairs hashes the set, and adding or removing a pair only
+ *         costs a XOR
+ */
+static inline uint64_t
+__csp_zobrist ( uint64_t a, uint64_t b )
+{
+	uint64_t z = a * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= (z >> 31) ^ b;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * \brief  A new stamp, different from all the ones given before in the process.
+ *         Not static, so that all the translation units share the counter
+ */
+inline uint64_t
+__csp_stamp ( void )
+{
+	static uint64_t stamps = 0;
+	return __csp_zobrist(__sync_add_and_fetch(&stamps, 1), 0);
+}
+
+/**
+ * \class CSPtranspositions csp++.h
+ * \brief Bounded table mapping the hash of the state of a CSP to the result of the
+ *        propagation started from it: whether the domains are consistent and, when
+ *        known, the domains it ends with. Each hash has a single slot, and a new
+ *        result takes the place of the one in its slot. The slots are guarded by
+ *        a set of locks, so a table can be shared by CSPs on different threads.
+ *        The hashes include a stamp of the model, so the results are only found
+ *        again by the CSP that stored them and by its copies
+ */
+class CSPtranspositions  {
+	struct __entry  {
+		uint64_t key;
+		bool used;
+		bool consistent;
+		bool exact;
+		std::vector<uint32_t> changes;
+	};
+
+	std::vector< __entry > __entries;
+	size_t __mask;
+	pthread_mutex_t __locks[__CSP_TABLE_LOCKS];
+
+	CSPtranspositions ( const CSPtranspositions& );
+	CSPtranspositions& operator= ( const CSPtranspositions& );
+
+public:
+	/**
+	 * \brief  Constructor
+	 * \param  entries Number of results kept, rounded up to a power of two
+	 */
+	explicit CSPtranspositions ( size_t entries = 65536 )
+	{
+		size_t n = 1;
+
+		while (n < entries)
+			n <<= 1;
+
+		__entries.resize(n);
+		__mask = n - 1;
+
+		for ( size_t i=0; i < n; i++ )
+			__entries[i].used = false;
+
+		for ( size_t i=0; i < __CSP_TABLE_LOCKS; i++ )
+			pthread_mutex_init(&__locks[i], NULL);
+	}
+
+	~CSPtranspositions ( void )
+	{
+		for ( size_t i=0; i < __CSP_TABLE_LOCKS; i++ )
+			pthread_mutex_destroy(&__locks[i]);
+	}
+
+	/**
+	 * \brief  Number of results the table can keep
+	 */
+	size_t capacity ( void ) const  { return __entries.size(); }
+
+	/**
+	 * \brief  Look up the result of a propagation
+	 * \param  key Hash of the state the propagation started from
+	 * \param  consistent Set to whether the domains were left consistent
+	 * \param  changes If not NULL, the result is only found if the domains it ends
+	 *           with are known, and they are copied here
+	 * \return true if the result was found
+	 */
+	bool find ( uint64_t key, bool &consistent, std::vector<uint32_t> *changes )
+	{
+		size_t slot = key & __mask;
+		pthread_mutex_t *lock = &__locks[slot % __CSP_TABLE_LOCKS];
+		const __entry &e = __entries[slot];
+		bool found;
+
+		pthread_mutex_lock(lock);
+		found = e.used && e.key == key && (!changes || e.exact);
+
+		if (found)  {
+			consistent = e.consistent;
+
+			if (changes)
+				*changes = e.changes;
+		}
+
+		pthread_mutex_unlock(lock);
+		return found;
+	}
+
+	/**
+	 * \brief  Store the result of a propagation
+	 * \param  key Hash of the state the propagation started from
+	 * \param  consistent Whether the domains were left consistent
+	 * \param  changes The domains the propagation ended with, or NULL if they
+	 *           aren't known. A result with its domains isn't replaced by the
+	 *           same result without them
+	 */
+	void store ( uint64_t key, bool consistent, const std::vector<uint32_t> *changes )
+	{
+		size_t slot = key & __mask;
+		pthread_mutex_t *lock = &__locks[slot % __CSP_TABLE_LOCKS];
+		__entry &e = __entries[slot];
+
+		pthread_mutex_lock(lock);
+
+		if (changes || !e.used || e.key != key || !e.exact)  {
+			e.key = key;
+			e.used = true;
+			e.consistent = consistent;
+			e.exact = (changes != NULL);
+
+			if (changes)
+				e.changes = *changes;
+			else
+				e.changes.clear();
+		}
+
+		pthread_mutex_unlock(lock);
+	}
+
+	/**
+	 * \brief  Drop all the results
+	 */
+	void clear ( void )
+	{
+		for ( size_t i=0; i < __entries.size(); i++ )  {
+			pthread_mutex_t *lock = &__locks[i % __CSP_TABLE_LOCKS];
+
+			pthread_mutex_lock(lock);
+			__entries[i].used = false;
+			std::vector<uint32_t>().swap(__entries[i].changes);
+			pthread_mutex_unlock(lock);
+		}
+	}
+};
+
+#endif
+
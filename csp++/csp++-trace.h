@@ -0,0 +1,286 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  csp++-trace.h
+ *
+ *    Description:  Optional tracing of the solver. While tracing is on, the library
+ *                  records timestamped begin/end events for the iterations of
+ *                  solve(), the propagation passes, the runs of the constraints and
+ *                  the searches, and instant events for the decisions and the
+ *                  backtracks. Each thread writes its events into its own ring
+ *                  buffer without taking any lock, and when tracing is stopped the
+ *                  buffers are written to a file in the Chrome Trace Event JSON
+ *                  format (open it in chrome://tracing or https://ui.perfetto.dev).
+ *                  Define CSP_NO_TRACE before including csp++.h to compile the
+ *                  tracing points away. Included by csp++.cpp
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 22:14:09
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_TRACE_H
+#define __CSPPP_TRACE_H
+
+#include	<string>
+#include	<cstdio>
+#include	<stdint.h>
+
+/**
+ * \struct __csp_event
+ * \brief  Event of the trace. The names are string literals, so only their
+ *         pointers are stored
+ */
+struct __csp_event  {
+	const char *name;
+	const char *arg_name;
+	int64_t arg;
+	double ts;
+	char phase;
+};
+
+/**
+ * \struct __csp_ring
+ * \brief  Ring buffer of the events of a thread. Only its thread writes into
+ *         it, and once it is full the oldest events are overwritten
+ */
+struct __csp_ring  {
+	__csp_event *events;
+	size_t capacity;
+	uint64_t written;
+	unsigned tid;
+	__csp_ring *next;
+};
+
+/**
+ * \struct __csp_tracer
+ * \brief  Global state of the tracing: the rings of the threads, linked in a list
+ *         which is extended with a compare-and-swap, and the generation of the
+ *         trace, which tells the threads when their ring belongs to a stopped one
+ */
+struct __csp_tracer  {
+	volatile bool enabled;
+	unsigned generation;
+	unsigned threads;
+	size_t capacity;
+	double start;
+	std::string file;
+	__csp_ring * volatile rings;
+};
+
+inline __csp_tracer&
+__csp_trace_state ( void )
+{
+	static __csp_tracer tracer = { false, 0, 0, 0, 0, std::string(), NULL };
+	return tracer;
+}
+
+/**
+ * \brief  Ring of the calling thread for the current trace, created and
+ *         registered the first time the thread records an event
+ */
+inline __csp_ring*
+__csp_trace_ring ( void )
+{
+	static __thread __csp_ring *ring = NULL;
+	static __thread unsigned generation = 0;
+	__csp_tracer &t = __csp_trace_state();
+
+	if (ring && generation == t.generation)
+		return ring;
+
+	ring = new __csp_ring;
+	ring->events = new __csp_event[t.capacity];
+	ring->capacity = t.capacity;
+	ring->written = 0;
+	ring->tid = __sync_add_and_fetch(&t.threads, 1);
+	generation = t.generation;
+
+	// The ring is pushed on the head of the list, retrying with the head seen
+	// by the failed compare-and-swap when another thread got there first
+	ring->next = NULL;
+
+	while (true)  {
+		__csp_ring *head = __sync_val_compare_and_swap(&t.rings, ring->next, ring);
+
+		if (head == ring->next)
+			break;
+
+		ring->next = head;
+	}
+
+	return ring;
+}
+
+/**
+ * \brief  Record an event in the ring of the calling thread
+ * \param  phase 'B' (begin), 'E' (end) or 'i' (instant)
+ * \param  name Name of the event
+ * \param  arg_name Name of the argument of the event, or NULL
+ * \param  arg Value of the argument
+ */
+inline void
+__csp_trace ( char phase, const char *name, const char *arg_name = NULL, int64_t arg = 0 )
+{
+	__csp_ring *ring = __csp_trace_ring();
+	__csp_event &e = ring->events[ring->written % ring->capacity];
+
+	e.name = name;
+	e.arg_name = arg_name;
+	e.arg = arg;
+	e.ts = __csp_now();
+	e.phase = phase;
+	ring->written++;
+}
+
+/**
+ * \class __csp_trace_scope
+ * \brief Records a begin event when built and the matching end event when
+ *        destroyed, so the scope is closed on any return path
+ */
+class __csp_trace_scope  {
+	const char *name;
+	bool on;
+
+public:
+	__csp_trace_scope ( const char *n, const char *arg_name = NULL, int64_t arg = 0 )  {
+		name = n;
+		on = __csp_trace_state().enabled;
+
+		if (on)
+			__csp_trace('B', name, arg_name, arg);
+	}
+
+	// Tracing may have been stopped, and the ring freed, while the scope was open
+	~__csp_trace_scope ( void )  {
+		if (on && __csp_trace_state().enabled)
+			__csp_trace('E', name);
+	}
+};
+
+#ifdef CSP_NO_TRACE
+#define 	__CSP_TRACE_SCOPE(...)
+#define 	__CSP_TRACE_INSTANT(...)
+#else
+#define 	__CSP_TRACE_SCOPE(...) 	__csp_trace_scope __csp_scope(__VA_ARGS__)
+#define 	__CSP_TRACE_INSTANT(...) 	\
+	do  { if (__csp_trace_state().enabled) __csp_trace('i', __VA_ARGS__); } while (0)
+#endif
+
+/**
+ * \class CSPtrace csp++.h
+ * \brief Tracing of the solver to a Chrome Trace Event JSON file. Tracing must
+ *        be started and stopped while no CSP is being solved
+ */
+class CSPtrace  {
+public:
+	/**
+	 * \brief  Start recording the events of the solver
+	 * \param  file Path of the JSON file written by stop()
+	 * \param  capacity Number of events kept for each thread: when more are
+	 *         recorded, only the latest ones are kept
+	 */
+	static void start ( std::string file, size_t capacity = 65536 )  {
+		__csp_tracer &t = __csp_trace_state();
+
+		if (capacity == 0)
+			throw CSPexception("Invalid capacity of the trace");
+
+		if (t.enabled)
+			stop();
+
+		t.file = file;
+		t.capacity = capacity;
+		t.threads = 0;
+		t.rings = NULL;
+		t.generation++;
+		t.start = __csp_now();
+		t.enabled = true;
+	}
+
+	/**
+	 * \brief  Check whether the events of the solver are being recorded
+	 * \return true if tracing is on
+	 */
+	static bool enabled ( void )  {
+		return __csp_trace_state().enabled;
+	}
+
+	/**
+	 * \brief  Stop recording the events and write them to the file given to
+	 *         start(), as a JSON array of trace events
+	 */
+	static void stop ( void )  {
+		__csp_tracer &t = __csp_trace_state();
+		FILE *out;
+		bool first = true;
+
+		if (!t.enabled)
+			return;
+
+		// The rings are freed below, so the threads must not find theirs again
+		t.enabled = false;
+		t.generation++;
+
+		if (!(out = fopen(t.file.c_str(), "w")))  {
+			__free(t);
+			throw CSPexception("Unable to write the trace file");
+		}
+
+		fprintf(out, "[\n");
+
+		for ( __csp_ring *r = t.rings; r; r = r->next )  {
+			uint64_t oldest = (r->written > r->capacity) ? r->written - r->capacity : 0;
+			size_t depth = 0;
+
+			for ( uint64_t i=oldest; i < r->written; i++ )  {
+				const __csp_event &e = r->events[i % r->capacity];
+
+				// The beginning of a scope may have been overwritten
+				if (e.phase == 'E' && depth == 0)
+					continue;
+
+				if (e.phase == 'B')
+					depth++;
+				else if (e.phase == 'E')
+					depth--;
+
+				fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"csp\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+					first ? "" : ",\n", e.name, e.phase, (e.ts - t.start) * 1e6, r->tid);
+
+				if (e.phase == 'i')
+					fprintf(out, ",\"s\":\"t\"");
+
+				if (e.arg_name)
+					fprintf(out, ",\"args\":{\"%s\":%lld}", e.arg_name, (long long) e.arg);
+
+				fprintf(out, "}");
+				first = false;
+			}
+		}
+
+		fprintf(out, "\n]\n");
+		fclose(out);
+		__free(t);
+	}
+
+private:
+	static void __free ( __csp_tracer &t )  {
+		while (t.rings)  {
+			__csp_ring *next = t.rings->next;
+			delete[] t.rings->events;
+			delete t.rings;
+			t.rings = next;
+		}
+	}
+};
+
+#endif
+
@@ -19,29 +19,137 @@
 
 
 #include	<algorithm>
+#include	<deque>
+#include	<map>
+#include	<utility>
+#include	<cstdio>
+#include	<cstring>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+
+#if __cplusplus >= 201103L
+#include	<type_traits>
+#endif
 
 #define   __CSPPP_CPP
 #include	"csp++-def.h"
 #undef    __CSPPP_CPP
 
+#include	"csp++-kernels.h"
+#include	"csp++-trace.h"
+
 using std::vector;
 
+/**
+ * \brief  Value of a variable used as the objective, as a number. Only the values
+ *         convertible to double can be used this way
+ */
+#if __cplusplus >= 201103L
+template<class T>
+inline typename std::enable_if<std::is_convertible<T, double>::value, double>::type
+__csp_number ( const T &value )
+{
+	return (double) value;
+}
+
+template<class T>
+inline typename std::enable_if<!std::is_convertible<T, double>::value, double>::type
+__csp_number ( const T& )
+{
+	throw CSPexception("The values of the objective variable are not numbers");
+}
+#else
+template<class T>
+inline double
+__csp_number ( const T &value )
+{
+	return (double) value;
+}
+#endif
+
+/**
+ * \brief  Writes the checkpoints asked for through setCheckpoint() during the
+ *         searches. Only the types which can be saved as raw bytes instantiate
+ *         CSP::checkpoint(), so the other ones still compile as long as no
+ *         checkpoint is asked for
+ */
+#if __cplusplus >= 201103L
+template<class T, bool trivial = std::is_trivially_copyable<T>::value>
+#else
+template<class T, bool trivial = true>
+#endif
+struct __csp_checkpointer  {
+	static void save ( CSP<T> &csp, const std::string &file )  { csp.checkpoint(file); }
+};
+
+template<class T>
+struct __csp_checkpointer<T, false>  {
+	static void save ( CSP<T>&, const std::string& )  {}
+};
+
 
 template<class T>
 void
 CSP<T>::__init (int n, bool (*c)(vector< CSPvariable<T> >))
 {
-	variables = vector< CSPvariable<T> >(n);
-	__default_domains = vector< vector<T> >(n);
+	__values = vector<T>(n);
+	__fixed.assign((n + 63) / 64, 0);
+	__offsets.assign(n, 0);
+	__sizes.assign(n, 0);
+	__capacities.assign(n, 0);
+	__synced = false;
 
-	for (size_t i=0; i < variables.size(); i++)  {
-		variables[i].index = i;
-		variables[i].fixed = false;
-	}
+	__default_domains = vector< vector<T> >(n);
+	__subscribers = vector< vector< std::pair<size_t, unsigned> > >(n);
 
 	constraints = vector< bool (*)(std::vector< CSPvariable<T> >) >(1);
 	constraint = c;
 	__has_default_value = false;
+
+	__nodes = 0;
+	__search_complete = false;
+	__objective = NULL;
+	__objective_var = -1;
+	__maximise = false;
+	__incumbent_callback = NULL;
+	__bounding = false;
+	__has_incumbent = false;
+	__incumbent = 0.0;
+
+	__counting = false;
+	__solutions = 0;
+	__solutions_limit = 0;
+
+	__checkpoint_every = 0;
+	__resuming = false;
+
+	__trailing = false;
+	__incremental = false;
+
+	__consistency = CSP_ARC;
+	__probe_fixed = false;
+	__removed = 0;
+	resetStats();
+	__resetOrder();
+
+	__transpositions = NULL;
+	__model = __csp_stamp();
+	__zobrist = 0;
+	__zobrist_removed.assign(n, 0);
+	__zobrist_set.assign(n, 0);
+
+	// The constraints over the whole set of variables are probed by a single
+	// propagator, woken up by any change of any domain. A probe is treated as
+	// idempotent, so it runs once unless other constraints change the domains
+	__running = -1;
+	__propagated = false;
+
+	for ( size_t c=0; c < CSP_PRIORITY_CLASSES; c++ )
+		__heads[c] = 0;
+
+	__addPropagator(&CSP<T>::__propagateLegacy, 0, vector<size_t>(), CSP_PRIORITY_GLOBAL, 0, true);
 }
 
 template<class T>
@@ -55,9 +163,9 @@ CSP<T>::CSP ( int n, T default_value, bool set_value, bool (*c)(std::vector< CSP
 {
 	__init (n, c);
 
-	for ( size_t i=0; i < variables.size(); i++ )  {
-		variables[i].value = default_value;
-		variables[i].fixed = set_value;
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		__values[i] = default_value;
+		__setFixed(i, set_value);
 	}
 
 	__default_value = default_value;
@@ -66,46 +174,255 @@ CSP<T>::CSP ( int n, T default_value, bool set_value, bool (*c)(std::vector< CSP
 
 template<class T>
 void
-CSP<T>::setDomain (size_t index, vector<T> domain)
+CSP<T>::__setFixed ( size_t var, bool fixed )
+{
+	__propagated = false;
+
+	if (fixed)
+		__fixed[var >> 6] |= (uint64_t) 1 << (var & 63);
+	else
+		__fixed[var >> 6] &= ~((uint64_t) 1 << (var & 63));
+}
+
+template<class T>
+void
+CSP<T>::__allocate ( size_t var, size_t size )
+{
+	// A slice too small for the new domain is left unused, and a new one is
+	// taken at the end of the pool
+	if (size <= __capacities[var])
+		return;
+
+	__offsets[var] = __pool.size();
+	__capacities[var] = size;
+	__pool.resize(__pool.size() + size);
+	__positions.resize(__pool.size());
+	__causes.resize(__pool.size(), -1);
+}
+
+template<class T>
+void
+CSP<T>::__setDefaultDomain ( size_t var )
+{
+	// The domains are kept sorted and without duplicates: the values removed
+	// from a slice keep the order of the ones left, so sorting the domain once
+	// here keeps every domain sorted
+	vector<T> &domain = __default_domains[var];
+
+	std::sort(domain.begin(), domain.end());
+	domain.erase( std::unique(domain.begin(), domain.end()), domain.end() );
+
+	__dropInferred();
+	__restoreDomain(var);
+	__hashValue(var);
+	__restamp();
+}
+
+template<class T>
+void
+CSP<T>::__restoreDomain ( size_t var )
+{
+	const vector<T> &domain = __default_domains[var];
+
+	__propagated = false;
+	__allocate(var, domain.size());
+	std::copy(domain.begin(), domain.end(), __domain(var));
+	__sizes[var] = domain.size();
+
+	for ( size_t i=0; i < domain.size(); i++ )
+		__positions[__offsets[var] + i] = i;
+
+	__hashDomain(var);
+}
+
+template<class T>
+const std::vector< CSPvariable<T> >&
+CSP<T>::__materialise ( void )
+{
+	__variables.resize(__values.size());
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		__variables[i].index = i;
+		__variables[i].fixed = __isFixed(i);
+		__variables[i].value = __values[i];
+		__variables[i].domain.assign(__domain(i), __domain(i) + __sizes[i]);
+	}
+
+	return __variables;
+}
+
+template<class T>
+void
+CSP<T>::__setState ( size_t var, bool fixed, const T &value )
 {
-	if (index >= variables.size())
+	__setFixed(var, fixed);
+	__values[var] = value;
+	__hashValue(var);
+
+	if (__synced)  {
+		__variables[var].fixed = fixed;
+		__variables[var].value = value;
+	}
+}
+
+template<class T>
+void
+CSP<T>::__sync ( size_t var )
+{
+	if (__synced)
+		__variables[var].domain.assign(__domain(var), __domain(var) + __sizes[var]);
+}
+
+template<class T>
+bool
+CSP<T>::__satisfied ( bool inferred )
+{
+	size_t nv = __view_constraints.size(), n = nv + constraints.size();
+	bool materialised = __synced;
+
+	if (__legacy_order.size() != n)
+		__resetOrder();
+
+	if (++__checks % __CSP_REORDER_EVERY == 0)
+		__reorderLegacy();
+
+	// The first constraint rejecting the variables ends the check, so the
+	// order only changes how soon. Without the inferred constraints, only the
+	// ones still probed are checked
+	for ( size_t i=0; i < n; i++ )  {
+		size_t k = __legacy_order[i];
+
+		if (k < nv)  {
+			if (!inferred && __isInferred(__view_constraints[k]))
+				continue;
+		} else {
+			if (constraints[k - nv] == __default_constraint || (!inferred && __isInferred(constraints[k - nv])))
+				continue;
+
+			if (!materialised)  {
+				__materialise();
+				materialised = true;
+			}
+		}
+
+		__profile &p = __profiles[k];
+		bool timed = (p.checks++ % __CSP_PROFILE_EVERY == 0);
+		double start = timed ? __csp_now() : 0.0;
+		bool accepted = __checkLegacy(k);
+
+		if (timed)  {
+			p.seconds += __csp_now() - start;
+			p.timed++;
+		}
+
+		if (!accepted)  {
+			p.rejections++;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__resetOrder ( void )
+{
+	size_t n = __view_constraints.size() + constraints.size();
+	__profile empty = { 0, 0, 0, 0.0 };
+
+	__legacy_order.resize(n);
+	__profiles.assign(n, empty);
+	__checks = 0;
+
+	for ( size_t i=0; i < n; i++ )
+		__legacy_order[i] = i;
+}
+
+template<class T>
+void
+CSP<T>::__reorderLegacy ( void )
+{
+	// A constraint is worth checking early if it's cheap and often rejects the
+	// variables: the constraints are sorted by their average time over the
+	// chance that they reject, smoothed so that the ones never rejecting yet
+	// are still ranked by their cost
+	vector<double> rank(__profiles.size());
+
+	for ( size_t k=0; k < __profiles.size(); k++ )  {
+		const __profile &p = __profiles[k];
+		double cost = p.timed ? p.seconds / p.timed : 0.0;
+		rank[k] = cost * (p.checks + 2.0) / (p.rejections + 1.0);
+	}
+
+	std::stable_sort(__legacy_order.begin(), __legacy_order.end(), __byRank(rank));
+	__stats.reorders++;
+}
+
+template<class T>
+void
+CSP<T>::setDomain (size_t index, const vector<T> &domain)
+{
+	if (index >= __values.size())
 		throw CSPexception("Index out of range");
 
-	variables[index].domain = domain;
 	__default_domains[index] = domain;
+	__setDefaultDomain(index);
 }
 
+#if __cplusplus >= 201103L
 template<class T>
 void
-CSP<T>::setDomain (size_t index, T domain[], int size)
+CSP<T>::setDomain (size_t index, vector<T> &&domain)
 {
-	if (index >= variables.size())
+	if (index >= __values.size())
 		throw CSPexception("Index out of range");
 
+	__default_domains[index] = std::move(domain);
+	__setDefaultDomain(index);
+}
+#endif
+
+template<class T>
+void
+CSP<T>::setDomain (size_t index, T domain[], int size)
+{
 	if (size < 0)
 		throw CSPexception("Invalid domain size");
 
-	variables[index].domain = vector<T>(size);
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
 
-	for (int i=0; i < size; i++)  {
-		variables[index].domain[i] = domain[i];
-		__default_domains[index].push_back(domain[i]);
-	}
+	__default_domains[index].assign(domain, domain + size);
+	__setDefaultDomain(index);
 }
 
 template<class T>
 void
 CSP<T>::setConstraint ( bool (*c)(vector< CSPvariable<T> >))
 {
+	__dropInferred();
 	constraints = vector< bool(*)(vector< CSPvariable<T > >) >(1);
 	constraint = c;
+	__resetOrder();
+
+	// The constraints over the whole set of variables are all probed by the
+	// first propagator, so replacing them is like removing and appending it
+	__removed_constraints.push_back(0);
+	__appended.push_back(0);
+	__restamp();
 }
 
 template<class T>
 void
-CSP<T>::setConstraint ( std::vector< bool(*)(std::vector< CSPvariable<T> >) > c )
+CSP<T>::setConstraint ( const std::vector< bool(*)(std::vector< CSPvariable<T> >) > &c )
 {
+	__dropInferred();
 	constraints = c;
+	__resetOrder();
+	__removed_constraints.push_back(0);
+	__appended.push_back(0);
+	__restamp();
 }
 
 template<class T>
@@ -113,229 +430,3908 @@ void
 CSP<T>::appendConstraint ( bool (*c)(vector< CSPvariable<T> >))
 {
 	constraints.push_back(c);
+	__resetOrder();
+	__appended.push_back(0);
+	__restamp();
 }
 
 template<class T>
 void
-CSP<T>::dropConstraint ( size_t index )
+CSP<T>::appendConstraint ( bool (*c)(const CSPview<T>&) )
 {
-	if (index >= constraints.size())
+	__view_constraints.push_back(c);
+	__resetOrder();
+	__appended.push_back(0);
+	__restamp();
+}
+
+template<class T>
+size_t
+CSP<T>::appendConstraint ( size_t x, bool (*c)(T) )
+{
+	if (x >= __values.size())
 		throw CSPexception("Index out of range");
 
-	constraints.erase( constraints.begin() + index );
+	// Domains only shrink, so the values accepted once are accepted forever and
+	// the constraint doesn't need to be woken up by any event
+	__unaries.push_back( std::make_pair(x, c) );
+	__addPropagator(&CSP<T>::__propagateUnary, __unaries.size() - 1, vector<size_t>(1, x),
+			CSP_PRIORITY_UNARY, 0, true);
+	return __propagators.size() - 2;
+}
+
+template<class T>
+size_t
+CSP<T>::appendConstraint ( size_t x, size_t y, bool (*c)(T, T), unsigned events )
+{
+	if (x >= __values.size() || y >= __values.size())
+		throw CSPexception("Index out of range");
+
+	__binary b;
+	b.x = x;
+	b.y = y;
+	b.rel = c;
+	b.support = NULL;
+
+	vector<size_t> scope(1, x);
+
+	if (y != x)
+		scope.push_back(y);
+
+	// A value always has a different one to pair with, until the other
+	// domain is reduced to a single value, while an ordering only depends
+	// on the bounds of the other domain
+	if (c == notEqual)  {
+		b.support = notEqualSupport;
+		events = CSP_EVENT_FIXED;
+	} else if (c == lessThan)  {
+		b.support = lessThanSupport;
+		events = CSP_EVENT_BOUNDS;
+	} else if (c == equal)  {
+		b.support = equalSupport;
+		events = CSP_EVENT_DOMAIN;
+	}
+
+	__binaries.push_back(b);
+	__addPropagator(&CSP<T>::__propagateBinary, __binaries.size() - 1, scope,
+			CSP_PRIORITY_BINARY, events, y != x);
+	return __propagators.size() - 2;
+}
+
+template<class T>
+size_t
+CSP<T>::appendConstraint ( size_t x, size_t y,
+		void (*s)(const T*, size_t, const T*, size_t, bool, char*),
+		unsigned events )
+{
+	if (x >= __values.size() || y >= __values.size())
+		throw CSPexception("Index out of range");
+
+	__binary b;
+	b.x = x;
+	b.y = y;
+	b.rel = NULL;
+	b.support = s;
+
+	vector<size_t> scope(1, x);
+
+	if (y != x)
+		scope.push_back(y);
+
+	__binaries.push_back(b);
+	__addPropagator(&CSP<T>::__propagateBinary, __binaries.size() - 1, scope,
+			CSP_PRIORITY_BINARY, events, y != x);
+	return __propagators.size() - 2;
 }
 
 template<class T>
 void
-CSP<T>::restoreDomains ( void )
+CSP<T>::notEqualSupport ( const T *values, size_t n, const T *other, size_t m,
+		bool, char *mask )
 {
-	for (int i=0; i < variables.size(); i++)
-		variables[i].domain = __default_domains[i];
+	if (m != 1)
+		std::fill(mask, mask + n, m == 0 ? 0 : 1);
+	else
+		__csp_mask(values, n, other[0], __CSP_NE, mask);
 }
 
 template<class T>
 void
-CSP<T>::refreshDomains ( void )
+CSP<T>::lessThanSupport ( const T *values, size_t n, const T *other, size_t m,
+		bool first, char *mask )
 {
-	vector< arc<T> > arcs;
-	restoreDomains();
+	T lo, hi;
 
-	for (typename vector< CSPvariable<T> >::iterator x = variables.begin(); x != variables.end(); x++)  {
-		for (typename vector< CSPvariable<T> >::iterator y = variables.begin(); y != variables.end(); y++)  {
-			T xOrigValue = x->value;
-			T yOrigValue = y->value;
+	if (m == 0)  {
+		std::fill(mask, mask + n, 0);
+		return;
+	}
 
-			for (size_t i=0; i < x->domain.size(); i++)  {
-				if ( x->fixed )  {
-					if ( x->domain[i] != x->value )
-						continue;
-				}
+	__csp_minmax(other, m, lo, hi);
 
-				x->value = x->domain[i];
+	if (first)
+		__csp_mask(values, n, hi, __CSP_LT, mask);
+	else
+		__csp_mask(values, n, lo, __CSP_GT, mask);
+}
 
-				for (size_t j=0; j < y->domain.size(); j++)  {
-					if ( y->fixed )  {
-						if ( y->domain[j] != y->value )
-							continue;
-					}
+template<class T>
+void
+CSP<T>::equalSupport ( const T *values, size_t n, const T *other, size_t m,
+		bool, char *mask )
+{
+	std::fill(mask, mask + n, 0);
 
-					y->value = y->domain[j];
-					bool isConfigurationValid = true;
+	for ( size_t j=0; j < m; j++ )
+		__csp_mask_or(values, n, other[j], mask);
+}
 
-					for ( typename std::vector< bool (*)(std::vector< CSPvariable<T> >) >::iterator c = constraints.begin();
-							c != constraints.end() && isConfigurationValid;
-							c++ ) {
-						if (!(*c)(variables))
-							isConfigurationValid = false;
-					}
+template<class T>
+size_t
+CSP<T>::appendConstraint ( const std::vector<size_t> &scope, bool (*c)(const std::vector<T>&),
+		CSPpriority priority, unsigned events )
+{
+	if (scope.empty())
+		throw CSPexception("Empty scope");
 
-					if (isConfigurationValid)  {
-						arc<T> a;
-						a.var[0] = *x; a.var[1] = *y;
-						a.value[0] = x->value; a.value[1] = y->value;
-						arcs.push_back(a);
-					}
-				}
+	if (priority < CSP_PRIORITY_UNARY || priority > CSP_PRIORITY_GLOBAL)
+		throw CSPexception("Invalid priority class");
 
-				y->value = yOrigValue;
-			}
+	for ( size_t i=0; i < scope.size(); i++ )  {
+		if (scope[i] >= __values.size())
+			throw CSPexception("Index out of range");
 
-			x->value = xOrigValue;
+		for ( size_t j=0; j < i; j++ )  {
+			if (scope[j] == scope[i])
+				throw CSPexception("Repeated variable in the scope");
 		}
+	}
 
-		vector<T> domain = vector<T>();
+	__scoped sc;
+	sc.scope = scope;
+	sc.check = c;
 
-		for (size_t i=0; i < arcs.size(); i++)  {
-			if (arcs[i].var[0].index == x->index ||
-					arcs[i].var[1].index == x->index)  {
-				T value = (arcs[i].var[0].index == x->index) ? arcs[i].value[0] : arcs[i].value[1];
-				bool found = false;
+	__scopeds.push_back(sc);
+	__addPropagator(&CSP<T>::__propagateScoped, __scopeds.size() - 1, scope, priority, events, true);
+	return __propagators.size() - 2;
+}
 
-				for (size_t j=0; j < domain.size() && !found; j++)  {
-					if (domain[j] == value)
-						found = true;
-				}
+template<class T>
+template<class E>
+size_t
+CSP<T>::appendConstraint ( const CSPconstraint<T, E> &c )
+{
+	return __lower(c.self());
+}
 
-				if (!found)  {
-					domain.push_back(value);
-				}
-			}
-		}
+template<class T>
+template<class Op>
+size_t
+CSP<T>::__lower ( const __csp_relation< T, Op, CSPvar<T>, CSPvar<T> > &c )
+{
+	// A relation between two variables is a binary constraint, but a variable
+	// compared with itself is a single leaf of an expression, evaluated as it
+	// is since the values may not support arithmetic
+	if (c.l.index == c.r.index)
+		return __lowerExpression(c, __csp_flag<false>());
 
-		sort(domain.begin(), domain.end());
-		x->domain = domain;
-	}
+	return __lowerPair(c.l.index, c.r.index, Op());
 }
 
 template<class T>
-std::vector<T>
-CSP<T>::domain ( size_t index )
+template<class Op, class L, class R>
+size_t
+CSP<T>::__lower ( const __csp_relation<T, Op, L, R> &c )
 {
-	if (index >= variables.size())
-		throw CSPexception("Index out of range");
+	return __lowerExpression(c, __csp_flag<__csp_relation<T, Op, L, R>::linear != 0>());
+}
 
-	return variables[index].domain;
+template<class T>
+template<class E>
+size_t
+CSP<T>::__lower ( const E &c )
+{
+	return __lowerExpression(c, __csp_flag<false>());
 }
 
 template<class T>
 size_t
-CSP<T>::size( void )
+CSP<T>::__lowerPair ( size_t x, size_t y, __csp_eq )
 {
-	return variables.size();
+	return appendConstraint(x, y, equal);
 }
 
 template<class T>
-void
-CSP<T>::setValue ( size_t index, T value )
+size_t
+CSP<T>::__lowerPair ( size_t x, size_t y, __csp_ne )
 {
-	if (index >= variables.size())
-		throw CSPexception("Index out of range");
+	return appendConstraint(x, y, notEqual);
+}
 
-	variables[index].value = value;
-	variables[index].fixed = true;
+template<class T>
+template<class Op>
+size_t
+CSP<T>::__lowerPair ( size_t x, size_t y, Op )
+{
+	return appendConstraint(x, y, &CSP<T>::template __orderSupport<Op>, CSP_EVENT_BOUNDS);
 }
 
 template<class T>
+template<class Op>
 void
-CSP<T>::unsetValue ( size_t index )
+CSP<T>::__orderSupport ( const T *values, size_t n, const T *other, size_t m,
+		bool first, char *mask )
 {
-	if (index >= variables.size())
-		throw CSPexception("Index out of range");
+	// A value is supported if it is in the relation with the bound of the
+	// other domain most likely to accept it
+	T lo, hi;
 
-	if (__has_default_value)
-		variables[index].value = __default_value;
-	variables[index].fixed = false;
+	if (m == 0)  {
+		std::fill(mask, mask + n, 0);
+		return;
+	}
+
+	__csp_minmax(other, m, lo, hi);
+
+	if (first)
+		__csp_mask(values, n, Op::upper ? hi : lo, Op::cmp, mask);
+	else
+		__csp_mask(values, n, Op::upper ? lo : hi, Op::converse, mask);
 }
 
 template<class T>
-bool
-CSP<T>::isSatisfiable ( void )
+template<class Op, class L, class R>
+size_t
+CSP<T>::__lowerExpression ( const __csp_relation<T, Op, L, R> &c, __csp_flag<true> )
 {
-	for ( size_t i=0; i < variables.size(); i++ ) {
-		if ( variables[i].domain.empty() )
-			return false;
+	// The terms of l - r are summed by variable, and compared with 0
+	vector< std::pair<size_t, T> > terms;
+	vector<size_t> vars;
+	__expression e;
+
+	e.constant = T();
+	c.l.terms(terms, e.constant, T(1));
+	c.r.terms(terms, e.constant, T(-1));
+	c.collect(vars, e.constants);
+	e.check = __evaluate< __csp_relation<T, Op, L, R> >;
+	__leaves(vars, e);
+	e.coefficients.assign(e.scope.size(), T());
+
+	for ( size_t i=0; i < terms.size(); i++ )  {
+		size_t j = std::find(e.scope.begin(), e.scope.end(), terms[i].first) - e.scope.begin();
+		e.coefficients[j] += terms[i].second;
 	}
 
-	return true;
+	return __addExpression(e, &CSP<T>::template __propagateLinear<Op>,
+			Op::bounds ? CSP_EVENT_BOUNDS : CSP_EVENT_FIXED);
 }
 
 template<class T>
-bool
-CSP<T>::hasUniqueSolution ( void )
+template<class E>
+size_t
+CSP<T>::__lowerExpression ( const E &c, __csp_flag<false> )
 {
-	for ( size_t i=0; i < variables.size(); i++ ) {
-		if (variables[i].domain.size() != 1)
-			return false;
-	}
+	vector<size_t> vars;
+	__expression e;
 
-	return true;
+	e.constant = T();
+	c.collect(vars, e.constants);
+	e.check = __evaluate<E>;
+	__leaves(vars, e);
+	return __addExpression(e, &CSP<T>::template __propagateExpression<E>, CSP_EVENT_DOMAIN);
 }
 
 template<class T>
 void
-CSP<T>::assignUniqueDomains ( void )
+CSP<T>::__leaves ( const vector<size_t> &vars, __expression &e )
 {
-	for ( int i=0; i < size(); i++ )  {
-		if (domain(i).size() == 1)
-			setValue( i, domain(i)[0] );
+	// A variable is in the scope once, however many leaves it appears in
+	for ( size_t i=0; i < vars.size(); i++ )  {
+		if (vars[i] >= __values.size())
+			throw CSPexception("Index out of range");
+
+		size_t j = std::find(e.scope.begin(), e.scope.end(), vars[i]) - e.scope.begin();
+
+		if (j == e.scope.size())
+			e.scope.push_back(vars[i]);
+
+		e.leaves.push_back(j);
 	}
 }
 
 template<class T>
-bool
-CSP<T>::isSet ( size_t index )
+size_t
+CSP<T>::__addExpression ( const __expression &e, bool (CSP<T>::*run)(size_t), unsigned events )
 {
-	if (index >= variables.size())
-		throw CSPexception("Index out of range");
-
-	return variables[index].fixed;
+	__expressions.push_back(e);
+	__addPropagator(run, __expressions.size() - 1, e.scope,
+			e.scope.size() == 1 ? CSP_PRIORITY_UNARY : CSP_PRIORITY_NARY, events, true);
+	return __propagators.size() - 2;
 }
 
 template<class T>
-T
-CSP<T>::value ( size_t index )
+template<class E>
+bool
+CSP<T>::__evaluate ( const T *x, size_t, const T *k )
 {
-	if (index >= variables.size())
-		throw CSPexception("Index out of range");
-
-	return variables[index].value;
+	return E::template eval<0, 0>(x, k);
 }
 
 template<class T>
-void
-CSP<T>::solve ( size_t max_iterations )
+size_t
+CSP<T>::appendConstraint ( const CSPallDifferent<T> &c )
 {
-	bool   changed = false;
-	size_t steps = 1;
-	vector< vector<T> > oldDomains(size());
+	const vector<size_t> &scope = c.scope;
 
-	do  {
-		if (max_iterations != 0)  {
-			if (steps++ > max_iterations)
-				break;
-		}
+	if (scope.empty())
+		throw CSPexception("Empty scope");
 
-		for ( size_t i=0; i < size(); i++ )  {
-			oldDomains[i] = variables[i].domain;
+	for ( size_t i=0; i < scope.size(); i++ )  {
+		if (scope[i] >= __values.size())
+			throw CSPexception("Index out of range");
+
+		for ( size_t j=0; j < i; j++ )  {
+			if (scope[j] == scope[i])
+				throw CSPexception("Repeated variable in the scope");
 		}
-		
-		refreshDomains();
-		assignUniqueDomains();
+	}
 
-		if (hasUniqueSolution())
-			break;
+	__expression e;
+	e.scope = scope;
+	e.constant = T();
+	e.check = __distinct;
 
-		changed = false;
+	for ( size_t i=0; i < scope.size(); i++ )
+		e.leaves.push_back(i);
 
-		for ( size_t i=0; i < size(); i++ )  {
-			if (domain(i).size() != oldDomains[i].size())
-				changed = true;
+	return __addExpression(e, &CSP<T>::__propagateAllDifferent, CSP_EVENT_DOMAIN);
+}
 
-			for ( size_t j=0; j < domain(i).size() && !changed; j++ ) {
-				if ( domain(i)[j] != oldDomains[i][j] )
-					changed = true;
-			}
-		}
-	} while (changed);
+template<class T>
+bool
+CSP<T>::__distinct ( const T *x, size_t n, const T* )
+{
+	vector<T> values(x, x + n);
+
+	std::sort(values.begin(), values.end());
+	return std::adjacent_find(values.begin(), values.end()) == values.end();
+}
+
+template<class T>
+void
+CSP<T>::__addPropagator ( bool (CSP<T>::*run)(size_t), size_t data, const std::vector<size_t> &scope,
+		CSPpriority priority, unsigned events, bool idempotent )
+{
+	__propagator p;
+	p.run = run;
+	p.data = data;
+	p.scope = scope;
+	p.priority = priority;
+	p.events = events;
+	p.idempotent = idempotent;
+
+	for ( size_t i=0; i < scope.size(); i++ )
+		__subscribers[scope[i]].push_back( std::make_pair(__propagators.size(), events) );
+
+	__propagators.push_back(p);
+	__queued.push_back(false);
+	__appended.push_back(__propagators.size() - 1);
+	__restamp();
+}
+
+template<class T>
+void
+CSP<T>::removeConstraint ( size_t id )
+{
+	// The ids count the propagators after the one of the constraints over the
+	// whole set of variables
+	size_t p = id + 1;
+
+	if (p >= __propagators.size() || !__propagators[p].run)
+		throw CSPexception("Invalid constraint id");
+
+	__propagator &prop = __propagators[p];
+
+	for ( size_t i=0; i < prop.scope.size(); i++ )  {
+		vector< std::pair<size_t, unsigned> > &subscribers = __subscribers[prop.scope[i]];
+
+		for ( size_t j=0; j < subscribers.size(); j++ )  {
+			if (subscribers[j].first == p)  {
+				subscribers.erase(subscribers.begin() + j);
+				break;
+			}
+		}
+	}
+
+	if (prop.run == &CSP<T>::__propagateUnary)
+		__unaries[prop.data].second = NULL;
+	else if (prop.run == &CSP<T>::__propagateBinary)  {
+		__binaries[prop.data].rel = NULL;
+		__binaries[prop.data].support = NULL;
+	} else if (prop.run == &CSP<T>::__propagateScoped)
+		__scopeds[prop.data].check = NULL;
+	else if (prop.run == &CSP<T>::__propagateInferred)
+		__inferreds[prop.data].allowed.clear();
+	else
+		__expressions[prop.data].check = NULL;
+
+	// The scope is kept, to find the values the constraint had removed
+	prop.run = NULL;
+	__removed_constraints.push_back(p);
+	__restamp();
+}
+
+template<class T>
+void
+CSP<T>::dropConstraint ( size_t index )
+{
+	if (index >= constraints.size())
+		throw CSPexception("Index out of range");
+
+	__dropInferred();
+	constraints.erase( constraints.begin() + index );
+	__resetOrder();
+	__removed_constraints.push_back(0);
+	__appended.push_back(0);
+	__restamp();
+}
+
+template<class T>
+void
+CSP<T>::restoreDomains ( void )
+{
+	for (size_t i=0; i < __values.size(); i++)
+		__restoreDomain(i);
+}
+
+template<class T>
+void
+CSP<T>::refreshDomains ( void )
+{
+	__CSP_TRACE_SCOPE("refreshDomains");
+
+	if (__propagated)
+		__propagated = __update();
+	else  {
+		bool consistent;
+
+		restoreDomains();
+		__applyBound();
+
+		// The same state propagated before gets back the same domains
+		uint64_t key = __key();
+
+		if (!__recall(key, consistent, true))  {
+			consistent = __runPropagation(NULL);
+			__remember(key, consistent, true);
+		}
+
+		__propagated = consistent && __consistency == CSP_ARC;
+	}
+
+	__appended.clear();
+	__removed_constraints.clear();
+}
+
+template<class T>
+bool
+CSP<T>::__giveBack ( size_t var, long cause )
+{
+	// The values removed by the given propagator come back into the domain
+	size_t size = __sizes[var], total = __default_domains[var].size();
+
+	if (size == total)
+		return false;
+
+	uint32_t *positions = &__positions[0] + __offsets[var];
+	const long *causes = &__causes[0] + __offsets[var];
+	bool found = false;
+
+	__mask.assign(total, 0);
+
+	for ( size_t i=size; i < total; i++ )  {
+		if (causes[positions[i]] == cause)  {
+			__mask[positions[i]] = 1;
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	for ( size_t i=0; i < size; i++ )
+		__mask[positions[i]] = 1;
+
+	// The slice is rebuilt with the values in their original order, and the
+	// ones still missing right after them
+	const vector<T> &domain = __default_domains[var];
+	T *values = __domain(var);
+	size_t kept = std::count(__mask.begin(), __mask.end(), 1), k = 0, r = kept;
+
+	for ( size_t i=0; i < total; i++ )  {
+		size_t j = __mask[i] ? k++ : r++;
+		values[j] = domain[i];
+		positions[j] = i;
+	}
+
+	__sizes[var] = kept;
+	__hashDomain(var);
+	__sync(var);
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__relax ( void )
+{
+	// The values removed by the removed constraints come back. A domain growing
+	// this way may give back a support to the values removed by the other
+	// constraints on its variable, so these come back too, and so on. The
+	// values still without support are removed again when the constraints on
+	// the variables whose domains grew are propagated
+	size_t n = __values.size();
+	bool legacy = __hasLegacyConstraints();
+	vector<char> grown(n, 0), undone(__propagators.size(), 0);
+	vector<size_t> pending;
+
+	for ( size_t i=0; i < __removed_constraints.size(); i++ )  {
+		size_t p = __removed_constraints[i];
+
+		if (!undone[p])  {
+			undone[p] = 1;
+			pending.push_back(p);
+		}
+	}
+
+	while (!pending.empty())  {
+		size_t p = pending.back();
+		pending.pop_back();
+
+		// The first propagator probes the constraints over all the variables
+		size_t m = p ? __propagators[p].scope.size() : n;
+
+		for ( size_t i=0; i < m; i++ )  {
+			size_t var = p ? __propagators[p].scope[i] : i;
+
+			if (!__giveBack(var, p) || grown[var])
+				continue;
+
+			grown[var] = 1;
+
+			// The values removed by a constraint over a single variable don't
+			// depend on its domain
+			for ( size_t j=0; j < __subscribers[var].size(); j++ )  {
+				size_t q = __subscribers[var][j].first;
+
+				if (!undone[q] && __propagators[q].run != &CSP<T>::__propagateUnary)  {
+					undone[q] = 1;
+					pending.push_back(q);
+				}
+			}
+
+			if (legacy && !undone[0])  {
+				undone[0] = 1;
+				pending.push_back(0);
+			}
+		}
+	}
+
+	for ( size_t var=0; var < n; var++ )  {
+		if (!grown[var])
+			continue;
+
+		for ( size_t j=0; j < __subscribers[var].size(); j++ )
+			__schedule(__subscribers[var][j].first);
+
+		if (legacy)
+			__schedule(0);
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__update ( void )
+{
+	double start = __csp_now();
+	size_t removed = __removed;
+
+	__relax();
+
+	for ( size_t i=0; i < __appended.size(); i++ )  {
+		size_t p = __appended[i];
+
+		if (p == 0 || __propagators[p].run)
+			__schedule(p);
+	}
+
+	__applyBound();
+
+	bool consistent = __runQueue() && isSatisfiable();
+	__record(CSP_ARC, start, removed);
+	return consistent;
+}
+
+template<class T>
+void
+CSP<T>::setTranspositions ( CSPtranspositions *table )
+{
+	__transpositions = table;
+	__rehash();
+}
+
+template<class T>
+void
+CSP<T>::__toggle ( size_t var, size_t from, size_t to )
+{
+	if (!__transpositions)
+		return;
+
+	const uint32_t *positions = &__positions[0] + __offsets[var];
+	uint64_t key = 0;
+
+	for ( size_t i=from; i < to; i++ )
+		key ^= __csp_zobrist(2*var, positions[i]);
+
+	__zobrist ^= key;
+	__zobrist_removed[var] ^= key;
+}
+
+template<class T>
+void
+CSP<T>::__hashDomain ( size_t var )
+{
+	if (!__transpositions)
+		return;
+
+	// The values missing from the domain are right past its end
+	__zobrist ^= __zobrist_removed[var];
+	__zobrist_removed[var] = 0;
+	__toggle(var, __sizes[var], __default_domains[var].size());
+}
+
+template<class T>
+void
+CSP<T>::__hashValue ( size_t var )
+{
+	if (!__transpositions)
+		return;
+
+	// A value is hashed by its position in the domain given to setDomain(),
+	// and all the values out of it by the same key, as they all empty the
+	// domain of the variable
+	const vector<T> &domain = __default_domains[var];
+	uint64_t key = 0;
+
+	if (__isFixed(var))
+		key = __csp_zobrist(2*var + 1, std::find(domain.begin(), domain.end(), __values[var]) - domain.begin());
+
+	__zobrist ^= __zobrist_set[var] ^ key;
+	__zobrist_set[var] = key;
+}
+
+template<class T>
+void
+CSP<T>::__rehash ( void )
+{
+	__zobrist = 0;
+	__zobrist_removed.assign(__values.size(), 0);
+	__zobrist_set.assign(__values.size(), 0);
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		__hashDomain(i);
+		__hashValue(i);
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__recall ( uint64_t key, bool &consistent, bool replay )
+{
+	if (!__transpositions || __hasLegacyConstraints())
+		return false;
+
+	vector<uint32_t> changes;
+	__stats.lookups++;
+
+	if (!__transpositions->find(key, consistent, replay ? &changes : NULL))
+		return false;
+
+	__stats.hits++;
+
+	// Each domain narrowed by the propagation is stored as its variable, its
+	// size, the positions of its values in the domain given to setDomain() in
+	// the order of its slice, and the propagator removing each missing value
+	for ( size_t i=0; i < changes.size(); )  {
+		size_t var = changes[i++], size = changes[i++];
+		const vector<T> &domain = __default_domains[var];
+		T *values = __domain(var);
+		uint32_t *positions = &__positions[0] + __offsets[var];
+		long *causes = &__causes[0] + __offsets[var];
+
+		for ( size_t j=0; j < domain.size(); j++ )  {
+			positions[j] = changes[i++];
+			values[j] = domain[positions[j]];
+		}
+
+		for ( size_t j=size; j < domain.size(); j++ )  {
+			uint32_t cause = changes[i++];
+			causes[positions[j]] = (cause == (uint32_t) -1) ? -1 : (long) cause;
+		}
+
+		__sizes[var] = size;
+		__hashDomain(var);
+		__sync(var);
+	}
+
+	__clearQueues();
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__remember ( uint64_t key, bool consistent, bool exact )
+{
+	if (!__transpositions || __hasLegacyConstraints())
+		return;
+
+	if (!exact)  {
+		__transpositions->store(key, consistent, NULL);
+		return;
+	}
+
+	vector<uint32_t> changes;
+
+	for ( size_t var=0; var < __values.size(); var++ )  {
+		size_t size = __sizes[var], total = __default_domains[var].size();
+
+		if (size == total)
+			continue;
+
+		const uint32_t *positions = &__positions[0] + __offsets[var];
+		const long *causes = &__causes[0] + __offsets[var];
+
+		changes.push_back(var);
+		changes.push_back(size);
+		changes.insert(changes.end(), positions, positions + total);
+
+		for ( size_t j=size; j < total; j++ )
+			changes.push_back((uint32_t) causes[positions[j]]);
+	}
+
+	__transpositions->store(key, consistent, &changes);
+}
+
+template<class T>
+bool
+CSP<T>::__runPropagation ( const size_t *var )
+{
+	double start = __csp_now();
+	size_t removed = __removed;
+	bool consistent;
+
+	// Node consistency is always applied, the other levels build on it
+	if (var)
+		consistent = __nodeConsistency(*var);
+	else
+		consistent = __nodeConsistency();
+
+	__record(CSP_NODE, start, removed);
+
+	if (!consistent)  {
+		__clearQueues();
+		return false;
+	}
+
+	start = __csp_now();
+	removed = __removed;
+
+	switch (__consistency)  {
+		case CSP_NODE:
+			consistent = __checkSet(var);
+			__clearQueues();
+			__stats.seconds[CSP_NODE] += __csp_now() - start;
+			__stats.removed[CSP_NODE] += __removed - removed;
+			return consistent;
+
+		case CSP_FORWARD:
+			consistent = __forwardChecking(var);
+			__clearQueues();
+			__record(CSP_FORWARD, start, removed);
+			return consistent;
+
+		default:
+			break;
+	}
+
+	// Setting the variable woke up the constraints depending on it
+	if (var)
+		consistent = __runQueue();
+	else
+		consistent = __arcPass();
+
+	__record(CSP_ARC, start, removed);
+
+	if (!consistent || __consistency == CSP_ARC)
+		return consistent;
+
+	start = __csp_now();
+	removed = __removed;
+
+	if (__consistency == CSP_PATH)  {
+		consistent = __pathConsistency();
+		__record(CSP_PATH, start, removed);
+	} else {
+		consistent = __singletonArcConsistency();
+		__record(CSP_SINGLETON_ARC, start, removed);
+	}
+
+	return consistent;
+}
+
+template<class T>
+void
+CSP<T>::__record ( CSPconsistency level, double start, size_t removed )
+{
+	__stats.runs[level]++;
+	__stats.seconds[level] += __csp_now() - start;
+	__stats.removed[level] += __removed - removed;
+}
+
+template<class T>
+bool
+CSP<T>::__nodeConsistency ( void )
+{
+	bool consistent = true;
+
+	// A set variable can only take its own value
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (!__isFixed(i))
+			continue;
+
+		if (!__nodeConsistency(i))
+			consistent = false;
+	}
+
+	// The constraints over a single variable are applied as their propagators,
+	// which the values they remove are ascribed to
+	for ( size_t p=1; p < __propagators.size(); p++ )  {
+		bool (CSP<T>::*run)(size_t) = __propagators[p].run;
+
+		if (run != &CSP<T>::__propagateUnary &&
+				(run != &CSP<T>::__propagateInferred || __propagators[p].scope.size() != 1))
+			continue;
+
+		__running = p;
+
+		if (!(this->*run)(__propagators[p].data))
+			consistent = false;
+
+		__running = -1;
+	}
+
+	return consistent;
+}
+
+template<class T>
+bool
+CSP<T>::__nodeConsistency ( size_t var )
+{
+	const T *domain = __domain(var);
+	size_t size = __sizes[var];
+
+	if (size == 1 && domain[0] == __values[var])
+		return true;
+
+	if (std::find(domain, domain + size, __values[var]) == domain + size)  {
+		__emptyDomain(var);
+		return false;
+	}
+
+	__mask.resize(size);
+	__csp_mask(domain, size, __values[var], __CSP_EQ, &__mask[0]);
+	__narrow(var, __mask);
+	return true;
+}
+
+template<class T>
+bool
+CSP<T>::__checkSet ( const size_t *var )
+{
+	// Only the constraints whose variables are all set are checked: their
+	// domains are single values, so propagating a violated one wipes out one
+	// of them
+	size_t n = var ? __subscribers[*var].size() : __propagators.size();
+
+	for ( size_t i = var ? 0 : 1; i < n; i++ )  {
+		size_t p = var ? __subscribers[*var][i].first : i;
+		const vector<size_t> &scope = __propagators[p].scope;
+		bool set = (__propagators[p].run != NULL);
+
+		for ( size_t j=0; j < scope.size() && set; j++ )
+			set = __isFixed(scope[j]);
+
+		if (set && !__runPropagator(p))
+			return false;
+	}
+
+	return __checkComplete();
+}
+
+template<class T>
+bool
+CSP<T>::__checkComplete ( void )
+{
+	// The constraints over the whole set of variables are checked as a whole
+	// once all the variables are set, also the ones propagated through the
+	// pairs of variables found by inferScopes()
+	if (!__hasLegacyConstraints())
+		return true;
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (!__isFixed(i))
+			return true;
+	}
+
+	if (!__satisfied())  {
+		__emptyDomain(0);
+		return false;
+	}
+
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__emptyDomain ( size_t var )
+{
+	size_t old_size = __sizes[var];
+
+	__save(var);
+	__toggle(var, 0, old_size);
+	__removed += old_size;
+	__sizes[var] = 0;
+	__reorder(var, old_size);
+	__sync(var);
+}
+
+template<class T>
+bool
+CSP<T>::__forwardChecking ( const size_t *var )
+{
+	__CSP_TRACE_SCOPE("forward checking");
+	// The constraints on the set variables are propagated once, without
+	// propagating the changes any further
+	vector<bool> done(var ? 0 : __propagators.size(), false);
+
+	for ( size_t v=0; v < __values.size(); v++ )  {
+		size_t y = var ? *var : v;
+
+		if (!__isFixed(y))
+			continue;
+
+		for ( size_t i=0; i < __subscribers[y].size(); i++ )  {
+			size_t p = __subscribers[y][i].first;
+
+			if (!var)  {
+				if (done[p])
+					continue;
+
+				done[p] = true;
+			}
+
+			if (!__runPropagator(p))
+				return false;
+		}
+
+		if (var)
+			break;
+	}
+
+	if (!__hasProbedConstraints())
+		return __checkComplete();
+
+	// Each value of an unset variable is checked alone against the constraints,
+	// instead of together with each value of each other variable
+	bool consistent = true;
+
+	__synced = __hasVectorConstraints();
+
+	if (__synced)
+		__materialise();
+
+	for ( size_t x=0; x < __values.size() && consistent; x++ )  {
+		if (__isFixed(x))
+			continue;
+
+		const T *domain = __domain(x);
+		T orig = __values[x];
+
+		__mask.resize(__sizes[x]);
+
+		for ( size_t i=0; i < __sizes[x]; i++ )  {
+			__setState(x, __probe_fixed, domain[i]);
+			__mask[i] = __satisfied(false);
+		}
+
+		__setState(x, false, orig);
+		__narrow(x, __mask);
+		consistent = (__sizes[x] > 0);
+	}
+
+	__synced = false;
+	return consistent && __checkComplete();
+}
+
+template<class T>
+bool
+CSP<T>::__arcPass ( void )
+{
+	__scheduleAll();
+	return __runQueue() && isSatisfiable();
+}
+
+template<class T>
+void
+CSP<T>::__legacyProbe ( void )
+{
+	// For each variable, the values found in some valid pair with a value of
+	// another variable. The domains are only narrowed when their variable is
+	// probed, so the positions in the slices still match until then
+	size_t n = __values.size();
+	vector< vector<char> > seen(n);
+
+	for ( size_t i=0; i < n; i++ )
+		seen[i].assign(__sizes[i], 0);
+
+	__synced = __hasVectorConstraints();
+
+	if (__synced)
+		__materialise();
+
+	for ( size_t x=0; x < n; x++ )  {
+		__CSP_TRACE_SCOPE("probe", "variable", x);
+
+		for ( size_t y=0; y < n; y++ )  {
+			const T *dx = __domain(x), *dy = __domain(y);
+			T xOrigValue = __values[x];
+			T yOrigValue = __values[y];
+			bool xOrigFixed = __isFixed(x);
+			bool yOrigFixed = __isFixed(y);
+
+			// The probed variables take the values being tried, and are only
+			// marked as set if setProbeFixed() was asked for
+			for ( size_t i=0; i < __sizes[x]; i++ )  {
+				if (xOrigFixed && dx[i] != xOrigValue)
+					continue;
+
+				__setState(x, xOrigFixed || __probe_fixed, dx[i]);
+
+				for ( size_t j=0; j < __sizes[y]; j++ )  {
+					if (yOrigFixed && dy[j] != yOrigValue)
+						continue;
+
+					__setState(y, yOrigFixed || __probe_fixed, dy[j]);
+
+					if (!__satisfied(false))
+						continue;
+
+					// Probing a variable against itself, its value is the last one set
+					if (x != y)
+						seen[x][i] = 1;
+
+					seen[y][j] = 1;
+				}
+
+				__setState(y, yOrigFixed, yOrigValue);
+			}
+
+			__setState(x, xOrigFixed, xOrigValue);
+			__setState(y, yOrigFixed, yOrigValue);
+		}
+
+		__narrow(x, seen[x]);
+	}
+
+	__synced = false;
+}
+
+template<class T>
+bool
+CSP<T>::__pathConsistency ( void )
+{
+	__CSP_TRACE_SCOPE("path consistency");
+	// Relations between each pair of variables sharing some constraints, as
+	// matrices over the indices of their current domains. Each one is tightened
+	// through the variables connected to both of them until a fixed point,
+	// removing from the domains the values left without support
+	typedef std::pair<size_t, size_t> edge;
+	std::map< edge, vector<char> > relations;
+	vector< std::set<size_t> > adjacent(__values.size());
+	vector< vector<char> > alive(__values.size());
+	vector<char> column;
+	bool changed = true;
+
+	for ( size_t i=0; i < __binaries.size(); i++ )  {
+		const __binary &c = __binaries[i];
+
+		if (c.x == c.y || (!c.rel && !c.support))
+			continue;
+
+		size_t a = std::min(c.x, c.y), b = std::max(c.x, c.y);
+		vector<char> &r = relations[edge(a, b)];
+		const T *da = __domain(a), *db = __domain(b);
+		size_t na = __sizes[a], nb = __sizes[b];
+
+		if (r.empty())
+			r.assign(na * nb, 1);
+
+		// Each column of the matrix holds the values of a supported by a
+		// single value of b
+		for ( size_t v=0; v < nb; v++ )  {
+			__supported(c, c.x == a, da, na, db + v, 1, column);
+
+			for ( size_t u=0; u < na; u++ )
+				r[u * nb + v] &= column[u];
+		}
+
+		adjacent[a].insert(b);
+		adjacent[b].insert(a);
+	}
+
+	for ( size_t i=0; i < __values.size(); i++ )
+		alive[i].assign(__sizes[i], 1);
+
+	while (changed)  {
+		changed = false;
+
+		for ( typename std::map< edge, vector<char> >::iterator e = relations.begin(); e != relations.end(); e++ )  {
+			size_t i = e->first.first, j = e->first.second;
+			size_t ni = __sizes[i], nj = __sizes[j];
+			vector<char> &rij = e->second;
+
+			for ( std::set<size_t>::iterator k = adjacent[i].begin(); k != adjacent[i].end(); k++ )  {
+				if (*k == j || !adjacent[j].count(*k))
+					continue;
+
+				size_t nk = __sizes[*k];
+				const vector<char> &rik = relations[edge(std::min(i, *k), std::max(i, *k))];
+				const vector<char> &rjk = relations[edge(std::min(j, *k), std::max(j, *k))];
+
+				for ( size_t u=0; u < ni; u++ )  {
+					for ( size_t v=0; v < nj; v++ )  {
+						bool path = false;
+
+						if (!rij[u * nj + v])
+							continue;
+
+						for ( size_t w=0; w < nk && !path; w++ )  {
+							if (!alive[*k][w])
+								continue;
+
+							path = (i < *k ? rik[u * nk + w] : rik[w * ni + u]) &&
+								(j < *k ? rjk[v * nk + w] : rjk[w * nj + v]);
+						}
+
+						if (!path)  {
+							rij[u * nj + v] = 0;
+							changed = true;
+						}
+					}
+				}
+			}
+
+			// Values without support in the tightened relation are removed
+			for ( size_t u=0; u < ni; u++ )  {
+				bool supported = false;
+
+				for ( size_t v=0; v < nj && !supported; v++ )
+					supported = alive[i][u] && alive[j][v] && rij[u * nj + v];
+
+				if (alive[i][u] && !supported)  {
+					alive[i][u] = 0;
+					changed = true;
+				}
+			}
+
+			for ( size_t v=0; v < nj; v++ )  {
+				bool supported = false;
+
+				for ( size_t u=0; u < ni && !supported; u++ )
+					supported = alive[i][u] && alive[j][v] && rij[u * nj + v];
+
+				if (alive[j][v] && !supported)  {
+					alive[j][v] = 0;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (__narrow(i, alive[i]) && __sizes[i] == 0)  {
+			__clearQueues();
+			return false;
+		}
+	}
+
+	// The removed values may leave others without support in the constraints
+	return __runQueue();
+}
+
+template<class T>
+bool
+CSP<T>::__singletonArcConsistency ( void )
+{
+	__CSP_TRACE_SCOPE("singleton arc consistency");
+	bool changed = true;
+
+	// A value is removed if assigning it to its variable makes arc consistency
+	// wipe out some domain. The trials are recorded on the trail and undone
+	while (changed)  {
+		changed = false;
+
+		for ( size_t x=0; x < __values.size(); x++ )  {
+			if (__isFixed(x) || __sizes[x] < 2)
+				continue;
+
+			vector<T> values(__domain(x), __domain(x) + __sizes[x]);
+			vector<char> kept(values.size(), 0);
+			bool trailing = __trailing;
+			size_t count = 0;
+
+			for ( size_t i=0; i < values.size(); i++ )  {
+				size_t mark = __trail.size();
+
+				__trailing = true;
+				__mask.resize(__sizes[x]);
+				__csp_mask(__domain(x), __sizes[x], values[i], __CSP_EQ, &__mask[0]);
+				__narrow(x, __mask);
+				kept[i] = __singletonPass(x);
+				__undo(mark);
+				__trailing = trailing;
+				count += kept[i];
+			}
+
+			if (count == values.size())
+				continue;
+
+			// The trials may have reordered the domain
+			__mask.assign(__sizes[x], 0);
+
+			for ( size_t i=0; i < values.size(); i++ )  {
+				if (kept[i])
+					__csp_mask_or(__domain(x), __sizes[x], values[i], &__mask[0]);
+			}
+
+			__narrow(x, __mask);
+			changed = true;
+
+			if (count == 0)  {
+				__clearQueues();
+				return false;
+			}
+
+			if (!__singletonPass(x))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+template<class T>
+bool
+CSP<T>::__singletonPass ( size_t x )
+{
+	if (!__hasLegacyConstraints())  {
+		__notify(x, CSP_EVENT_DOMAIN | CSP_EVENT_BOUNDS | CSP_EVENT_FIXED);
+		return __runQueue();
+	}
+
+	// The variables left with a single value take it (and are marked as set,
+	// if setProbeFixed() was asked for) while the probe is repeated until a
+	// fixed point, and get back their state afterwards
+	vector< std::pair<size_t, T> > forced;
+	vector<char> pinned(__values.size(), 0);
+	size_t removed;
+	bool consistent, grown;
+
+	do  {
+		removed = __removed;
+		consistent = __arcPass();
+		grown = false;
+
+		for ( size_t i=0; i < __values.size() && consistent; i++ )  {
+			if (__isFixed(i) || pinned[i] || __sizes[i] != 1)
+				continue;
+
+			forced.push_back( std::make_pair(i, __values[i]) );
+			pinned[i] = 1;
+			__setState(i, __probe_fixed, __domain(i)[0]);
+			grown = true;
+		}
+	} while (consistent && (grown || removed != __removed));
+
+	for ( size_t i=forced.size(); i > 0; i-- )
+		__setState(forced[i-1].first, false, forced[i-1].second);
+
+	return consistent;
+}
+
+template<class T>
+bool
+CSP<T>::__hasLegacyConstraints ( void ) const
+{
+	return !__view_constraints.empty() || __hasVectorConstraints();
+}
+
+template<class T>
+bool
+CSP<T>::__hasProbedConstraints ( void ) const
+{
+	for ( size_t i=0; i < __view_constraints.size(); i++ )  {
+		if (!__isInferred(__view_constraints[i]))
+			return true;
+	}
+
+	for ( size_t i=0; i < constraints.size(); i++ )  {
+		if (constraints[i] != __default_constraint && !__isInferred(constraints[i]))
+			return true;
+	}
+
+	return false;
+}
+
+template<class T>
+bool
+CSP<T>::__isInferred ( bool (*c)(std::vector< CSPvariable<T> >) ) const
+{
+	return std::find(__inferred_constraints.begin(), __inferred_constraints.end(), c) != __inferred_constraints.end();
+}
+
+template<class T>
+bool
+CSP<T>::__isInferred ( bool (*c)(const CSPview<T>&) ) const
+{
+	return std::find(__inferred_views.begin(), __inferred_views.end(), c) != __inferred_views.end();
+}
+
+template<class T>
+bool
+CSP<T>::__checkLegacy ( size_t k )
+{
+	// The constraints taking a view come first, then the ones taking the vector
+	// of variables, which must be up to date
+	if (k < __view_constraints.size())
+		return __view_constraints[k](view());
+
+	return constraints[k - __view_constraints.size()](__variables);
+}
+
+template<class T>
+void
+CSP<T>::__dropInferred ( void )
+{
+	for ( size_t i=0; i < __inferred_ids.size(); i++ )  {
+		if (__propagators[ __inferred_ids[i] ].run)
+			removeConstraint(__inferred_ids[i] - 1);
+	}
+
+	__inferred_ids.clear();
+	__inferred_constraints.clear();
+	__inferred_views.clear();
+}
+
+template<class T>
+bool
+CSP<T>::__hasVectorConstraints ( void ) const
+{
+	for ( size_t i=0; i < constraints.size(); i++ )  {
+		if (constraints[i] != __default_constraint)
+			return true;
+	}
+
+	return false;
+}
+
+template<class T>
+bool
+CSP<T>::__revise ( size_t x, const __binary &c )
+{
+	bool first = (c.x == x);
+	size_t y = first ? c.y : c.x;
+
+	// Two or more values in the other domain always support any value
+	// for a not-equal constraint
+	if (c.rel == notEqual && __sizes[y] > 1)
+		return false;
+
+	__supported(c, first, __domain(x), __sizes[x], __domain(y), __sizes[y], __mask);
+	return __narrow(x, __mask);
+}
+
+template<class T>
+void
+CSP<T>::__supported ( const __binary &c, bool first, const T *values, size_t n,
+		const T *other, size_t m, std::vector<char> &mask )
+{
+	mask.resize(n);
+
+	if (n == 0)
+		return;
+
+	if (c.support)  {
+		c.support(values, n, other, m, first, &mask[0]);
+		return;
+	}
+
+	for ( size_t i=0; i < n; i++ )  {
+		bool supported = false;
+
+		for ( size_t j=0; j < m && !supported; j++ )
+			supported = first ? c.rel(values[i], other[j]) : c.rel(other[j], values[i]);
+
+		mask[i] = supported;
+	}
+}
+
+template<class T>
+void
+CSP<T>::__bounds ( size_t var, T &lo, T &hi )
+{
+	__csp_minmax(__domain(var), __sizes[var], lo, hi);
+}
+
+template<class T>
+bool
+CSP<T>::__narrow ( size_t var, const std::vector<char> &keep )
+{
+	T *domain = __domain(var);
+	size_t size = __sizes[var], kept = 0, i = 0;
+	T lo, hi;
+
+	while (i < size && keep[i])
+		i++;
+
+	if (i == size)
+		return false;
+
+	uint32_t *positions = &__positions[0] + __offsets[var];
+
+	// The kept values are moved to the front in their order, and the removed
+	// ones right after them, where undoing the change finds them again
+	__bounds(var, lo, hi);
+	__save(var);
+	__spare.clear();
+	__spare_positions.clear();
+
+	for ( i=0; i < size; i++ )  {
+		if (keep[i])  {
+			domain[kept] = domain[i];
+			positions[kept++] = positions[i];
+		} else {
+			__spare.push_back(domain[i]);
+			__spare_positions.push_back(positions[i]);
+			__causes[__offsets[var] + positions[i]] = __running;
+		}
+	}
+
+	std::copy(__spare.begin(), __spare.end(), domain + kept);
+	std::copy(__spare_positions.begin(), __spare_positions.end(), positions + kept);
+	__toggle(var, kept, size);
+	__sizes[var] = kept;
+	__sync(var);
+	__narrowed(var, size, lo, hi);
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__restore ( size_t var, size_t size )
+{
+	size_t kept = __sizes[var], i = 0, j = kept;
+
+	__toggle(var, kept, size);
+	__sizes[var] = size;
+
+	if (kept == 0 || kept == size)
+		return;
+
+	T *domain = __domain(var);
+	uint32_t *positions = &__positions[0] + __offsets[var];
+
+	if (positions[kept-1] < positions[kept])
+		return;
+
+	// The kept values and the removed ones are both in their original order,
+	// so merging them by position gives back the domain as it was
+	__spare.clear();
+	__spare_positions.clear();
+
+	while (i < kept || j < size)  {
+		size_t k = (j == size || (i < kept && positions[i] < positions[j])) ? i++ : j++;
+		__spare.push_back(domain[k]);
+		__spare_positions.push_back(positions[k]);
+	}
+
+	std::copy(__spare.begin(), __spare.end(), domain);
+	std::copy(__spare_positions.begin(), __spare_positions.end(), positions);
+}
+
+template<class T>
+void
+CSP<T>::__narrowed ( size_t var, size_t old_size, const T &lo, const T &hi )
+{
+	size_t size = __sizes[var];
+	unsigned events = CSP_EVENT_DOMAIN;
+
+	__removed += old_size - size;
+	__reorder(var, old_size);
+
+	if (size == 0)
+		return;
+
+	if (size == 1)
+		events |= CSP_EVENT_FIXED;
+
+	T new_lo, new_hi;
+	__bounds(var, new_lo, new_hi);
+
+	if (new_lo != lo || new_hi != hi)
+		events |= CSP_EVENT_BOUNDS;
+
+	__notify(var, events);
+}
+
+template<class T>
+void
+CSP<T>::__notify ( size_t var, unsigned events )
+{
+	const vector< std::pair<size_t, unsigned> > &subscribers = __subscribers[var];
+
+	for ( size_t i=0; i < subscribers.size(); i++ )  {
+		if (subscribers[i].second & events)
+			__schedule(subscribers[i].first);
+	}
+
+	if (__hasLegacyConstraints())
+		__schedule(0);
+}
+
+template<class T>
+void
+CSP<T>::__schedule ( size_t p )
+{
+	if (__queued[p])
+		return;
+
+	if ((long) p == __running && __propagators[p].idempotent)
+		return;
+
+	__queued[p] = true;
+	__queues[__propagators[p].priority].push_back(p);
+}
+
+template<class T>
+void
+CSP<T>::__scheduleAll ( void )
+{
+	for ( size_t p = __hasLegacyConstraints() ? 0 : 1; p < __propagators.size(); p++ )  {
+		if (__propagators[p].run)
+			__schedule(p);
+	}
+}
+
+template<class T>
+void
+CSP<T>::__clearQueues ( void )
+{
+	for ( size_t c=0; c < CSP_PRIORITY_CLASSES; c++ )  {
+		for ( size_t i=__heads[c]; i < __queues[c].size(); i++ )
+			__queued[__queues[c][i]] = false;
+
+		__queues[c].clear();
+		__heads[c] = 0;
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__runQueue ( void )
+{
+	__CSP_TRACE_SCOPE("propagation queue");
+
+	// Each class is a FIFO queue: a wave of changes is propagated one step
+	// at a time, which finds wipe-outs sooner than following a single chain
+	while (true)  {
+		size_t c = 0;
+
+		while (c < CSP_PRIORITY_CLASSES && __heads[c] == __queues[c].size())
+			c++;
+
+		if (c == CSP_PRIORITY_CLASSES)  {
+			__clearQueues();
+			return true;
+		}
+
+		size_t p = __queues[c][__heads[c]++];
+		__queued[p] = false;
+
+		if (!__runPropagator(p))  {
+			__clearQueues();
+			return false;
+		}
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__runPropagator ( size_t p )
+{
+	static const char *names[CSP_PRIORITY_CLASSES] = {
+		"unary constraint", "binary constraint", "n-ary constraint", "global constraint"
+	};
+
+	__CSP_TRACE_SCOPE(names[__propagators[p].priority], "constraint", p);
+	bool consistent;
+
+	__running = p;
+	consistent = (this->*__propagators[p].run)(__propagators[p].data);
+	__running = -1;
+	return consistent;
+}
+
+template<class T>
+bool
+CSP<T>::__propagateUnary ( size_t u )
+{
+	size_t x = __unaries[u].first;
+	const T *domain = __domain(x);
+
+	__mask.resize(__sizes[x]);
+
+	for ( size_t i=0; i < __sizes[x]; i++ )
+		__mask[i] = __unaries[u].second(domain[i]);
+
+	__narrow(x, __mask);
+	return __sizes[x] > 0;
+}
+
+template<class T>
+bool
+CSP<T>::__propagateBinary ( size_t b )
+{
+	// Revising y after x leaves x consistent: a value removed from y supports
+	// no value of x, so the pair of revisions reaches a fixed point
+	const __binary &c = __binaries[b];
+
+	__revise(c.x, c);
+
+	if (__sizes[c.x] == 0)
+		return false;
+
+	__revise(c.y, c);
+	return __sizes[c.y] > 0;
+}
+
+template<class T>
+bool
+CSP<T>::__propagateScoped ( size_t s )
+{
+	// All the combinations of values of the domains are tried, until each
+	// value is found in an accepted one. The values never found are removed,
+	// and the others are still supported afterwards by the combinations
+	// which accepted them, so the propagator is idempotent
+	const __scoped &c = __scopeds[s];
+	size_t n = c.scope.size();
+	vector<T> tuple(n);
+	vector<size_t> pos(n, 0);
+	vector< vector<char> > supported(n);
+	size_t missing = 0;
+
+	for ( size_t i=0; i < n; i++ )  {
+		size_t size = __sizes[c.scope[i]];
+
+		if (size == 0)
+			return false;
+
+		supported[i].assign(size, 0);
+		missing += size;
+	}
+
+	while (missing > 0)  {
+		size_t i;
+
+		for ( i=0; i < n; i++ )
+			tuple[i] = __domain(c.scope[i])[pos[i]];
+
+		if (c.check(tuple))  {
+			for ( i=0; i < n; i++ )  {
+				if (!supported[i][pos[i]])  {
+					supported[i][pos[i]] = 1;
+					missing--;
+				}
+			}
+		}
+
+		for ( i=0; i < n && ++pos[i] == supported[i].size(); i++ )
+			pos[i] = 0;
+
+		if (i == n)
+			break;
+	}
+
+	for ( size_t i=0; i < n && missing > 0; i++ )  {
+		if (__narrow(c.scope[i], supported[i]) && __sizes[c.scope[i]] == 0)
+			return false;
+	}
+
+	return true;
+}
+
+template<class T>
+template<class E>
+bool
+CSP<T>::__propagateExpression ( size_t e )
+{
+	// Same as __propagateScoped(), with the values of the leaves read from the
+	// combination of values of the scope and the expression evaluated inline
+	const __expression &c = __expressions[e];
+	size_t n = c.scope.size(), m = c.leaves.size();
+	const T *k = c.constants.empty() ? NULL : &c.constants[0];
+	const size_t *leaves = &c.leaves[0];
+	vector<T> x(m);
+	vector<size_t> pos(n, 0);
+	vector<const T*> domains(n);
+	vector< vector<char> > supported(n);
+	size_t missing = 0;
+
+	for ( size_t i=0; i < n; i++ )  {
+		size_t size = __sizes[c.scope[i]];
+
+		if (size == 0)
+			return false;
+
+		domains[i] = __domain(c.scope[i]);
+		supported[i].assign(size, 0);
+		missing += size;
+	}
+
+	while (missing > 0)  {
+		size_t i;
+
+		for ( i=0; i < m; i++ )
+			x[i] = domains[leaves[i]][pos[leaves[i]]];
+
+		if (E::template eval<0, 0>(&x[0], k))  {
+			for ( i=0; i < n; i++ )  {
+				if (!supported[i][pos[i]])  {
+					supported[i][pos[i]] = 1;
+					missing--;
+				}
+			}
+		}
+
+		for ( i=0; i < n && ++pos[i] == supported[i].size(); i++ )
+			pos[i] = 0;
+
+		if (i == n)
+			break;
+	}
+
+	for ( size_t i=0; i < n && missing > 0; i++ )  {
+		if (__narrow(c.scope[i], supported[i]) && __sizes[c.scope[i]] == 0)
+			return false;
+	}
+
+	return true;
+}
+
+template<class T>
+template<class Op>
+bool
+CSP<T>::__propagateLinear ( size_t e )
+{
+	// A value v of a variable with coefficient a is kept if a * v plus some
+	// value of the sum of the other terms may be in the relation with 0. That
+	// sum lies between the sums of the smallest and of the largest values of
+	// the terms, so the domains are narrowed until no value is removed
+	const __expression &c = __expressions[e];
+	size_t n = c.scope.size();
+	vector<T> lo(n), hi(n);
+	bool changed = true;
+
+	while (changed)  {
+		T min = c.constant, max = c.constant;
+		changed = false;
+
+		for ( size_t i=0; i < n; i++ )  {
+			size_t var = c.scope[i];
+			const T &a = c.coefficients[i];
+			T l, h;
+
+			if (__sizes[var] == 0)
+				return false;
+
+			__bounds(var, l, h);
+			lo[i] = (a < 0) ? a * h : a * l;
+			hi[i] = (a < 0) ? a * l : a * h;
+			min += lo[i];
+			max += hi[i];
+		}
+
+		for ( size_t i=0; i < n; i++ )  {
+			size_t var = c.scope[i];
+			const T *domain = __domain(var);
+			T rest_min = min - lo[i], rest_max = max - hi[i];
+
+			__mask.resize(__sizes[var]);
+
+			for ( size_t j=0; j < __sizes[var]; j++ )  {
+				T t = c.coefficients[i] * domain[j];
+				__mask[j] = Op::feasible(t + rest_min, t + rest_max);
+			}
+
+			if (__narrow(var, __mask))  {
+				if (__sizes[var] == 0)
+					return false;
+
+				changed = true;
+			}
+		}
+	}
+
+	return true;
+}
+
+template<class T>
+bool
+CSP<T>::__propagateAllDifferent ( size_t e )
+{
+	const __expression &c = __expressions[e];
+	size_t n = c.scope.size();
+	vector<T> fixed, values, single;
+	vector<size_t> open;
+
+	while (true)  {
+		// The values of the variables reduced to a single value are removed
+		// from the other domains, until no more domain is reduced this way. A
+		// value taken twice wipes out the domain of one of the variables
+		// taking it
+		size_t last = n + 1;
+
+		while (true)  {
+			fixed.clear();
+			open.clear();
+
+			for ( size_t i=0; i < n; i++ )  {
+				size_t var = c.scope[i];
+
+				if (__sizes[var] == 0)
+					return false;
+
+				if (__sizes[var] == 1)
+					fixed.push_back(__domain(var)[0]);
+				else
+					open.push_back(var);
+			}
+
+			if (fixed.empty() || fixed.size() == last)
+				break;
+
+			last = fixed.size();
+			std::sort(fixed.begin(), fixed.end());
+			typename vector<T>::iterator twice = std::adjacent_find(fixed.begin(), fixed.end());
+
+			if (twice != fixed.end())  {
+				for ( size_t i=0; i < n; i++ )  {
+					size_t var = c.scope[i];
+
+					if (__sizes[var] == 1 && __domain(var)[0] == *twice)  {
+						__mask.assign(1, 0);
+						__narrow(var, __mask);
+						break;
+					}
+				}
+
+				return false;
+			}
+
+			for ( size_t i=0; i < open.size(); i++ )  {
+				size_t var = open[i];
+				const T *domain = __domain(var);
+
+				__mask.resize(__sizes[var]);
+
+				for ( size_t j=0; j < __sizes[var]; j++ )
+					__mask[j] = !std::binary_search(fixed.begin(), fixed.end(), domain[j]);
+
+				if (__narrow(var, __mask) && __sizes[var] == 0)
+					return false;
+			}
+		}
+
+		// After the naked singles, the values of the fixed variables are left
+		// in no other domain, so only the variables not fixed yet are checked.
+		// They can't take different values if their domains hold fewer values
+		// than there are variables. If they hold as many, each value is taken
+		// by some variable, so a value left in a single domain is the value of
+		// its variable
+		values.clear();
+
+		for ( size_t i=0; i < open.size(); i++ )
+			values.insert(values.end(), __domain(open[i]), __domain(open[i]) + __sizes[open[i]]);
+
+		if (open.empty())
+			return true;
+
+		std::sort(values.begin(), values.end());
+		single.clear();
+		size_t distinct = 0;
+
+		for ( size_t a=0, b; a < values.size(); a = b )  {
+			for ( b = a+1; b < values.size() && values[b] == values[a]; b++ )
+				;
+
+			if (b == a+1)
+				single.push_back(values[a]);
+
+			distinct++;
+		}
+
+		if (distinct < open.size())  {
+			__mask.assign(__sizes[open[0]], 0);
+			__narrow(open[0], __mask);
+			return false;
+		}
+
+		if (distinct > open.size() || single.empty())
+			return true;
+
+		// A variable owning two of these values can only take one of them, and
+		// the other one is left without variables at the next round
+		for ( size_t i=0; i < open.size(); i++ )  {
+			size_t var = open[i];
+			const T *domain = __domain(var);
+
+			for ( size_t j=0; j < __sizes[var]; j++ )  {
+				if (std::binary_search(single.begin(), single.end(), domain[j]))  {
+					__mask.resize(__sizes[var]);
+					__csp_mask(domain, __sizes[var], domain[j], __CSP_EQ, &__mask[0]);
+					__narrow(var, __mask);
+					break;
+				}
+			}
+		}
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__propagateLegacy ( size_t )
+{
+	// The constraints over the whole set of variables don't say which variables
+	// they involve, so every pair of variables is probed, unless they were all
+	// split by inferScopes() into constraints between two variables
+	if (__hasProbedConstraints())
+		__legacyProbe();
+
+	return isSatisfiable() && __checkComplete();
+}
+
+template<class T>
+bool
+CSP<T>::__propagateInferred ( size_t i )
+{
+	// Same as __propagateBinary(), with the pairs of values looked up in the
+	// table of the constraint
+	const __inferred &c = __inferreds[i];
+
+	__reviseInferred(c.x, c);
+
+	if (__sizes[c.x] == 0)
+		return false;
+
+	if (c.y == c.x)
+		return true;
+
+	__reviseInferred(c.y, c);
+	return __sizes[c.y] > 0;
+}
+
+template<class T>
+bool
+CSP<T>::__reviseInferred ( size_t x, const __inferred &c )
+{
+	bool first = (c.x == x);
+	size_t y = first ? c.y : c.x, n = __sizes[x], m = __sizes[y];
+	size_t width = __default_domains[c.y].size();
+
+	if (n == 0)
+		return false;
+
+	const uint32_t *px = &__positions[0] + __offsets[x];
+	const uint32_t *py = &__positions[0] + __offsets[y];
+
+	__mask.resize(n);
+
+	for ( size_t i=0; i < n; i++ )  {
+		bool supported = false;
+
+		if (c.x == c.y)
+			supported = c.allowed[px[i]];
+
+		for ( size_t j=0; j < m && !supported && c.x != c.y; j++ )
+			supported = c.allowed[first ? px[i] * width + py[j] : py[j] * width + px[i]];
+
+		__mask[i] = supported;
+	}
+
+	return __narrow(x, __mask);
+}
+
+template<class T>
+size_t
+CSP<T>::inferScopes ( void )
+{
+	__CSP_TRACE_SCOPE("infer scopes");
+	size_t n = __values.size(), nv = __view_constraints.size(), inferred = 0;
+	std::map< std::pair<size_t, size_t>, vector<char> > tables;
+	vector< vector<char> > alone(n);
+	vector<T> values(__values);
+	vector<char> fixed(n);
+
+	// The value every unset variable holds during the checks, whatever it held
+	// before, so that a constraint reading it sees the same one for each pair
+	const T blank = __has_default_value ? __default_value : T();
+
+	__dropInferred();
+	__synced = __hasVectorConstraints();
+
+	if (__synced)
+		__materialise();
+
+	// The constraints are checked with all the variables unset, but the ones
+	// whose values are being tried
+	for ( size_t i=0; i < n; i++ )  {
+		fixed[i] = __isFixed(i);
+		__setState(i, false, blank);
+	}
+
+	for ( size_t k=0; k < nv + constraints.size(); k++ )  {
+		if (k >= nv && constraints[k - nv] == __default_constraint)
+			continue;
+
+		if (!__checkLegacy(k))
+			continue;
+
+		// Values rejected alone, and pairs of values accepted alone but rejected
+		// together. A pair accepted together with a value rejected alone means
+		// that the constraint doesn't only reject combinations of set values
+		std::map< std::pair<size_t, size_t>, vector<char> > found;
+		bool pairwise = true;
+
+		for ( size_t x=0; x < n; x++ )  {
+			const vector<T> &dx = __default_domains[x];
+			alone[x].assign(dx.size(), 1);
+
+			for ( size_t a=0; a < dx.size(); a++ )  {
+				__setState(x, true, dx[a]);
+
+				if (__checkLegacy(k))
+					continue;
+
+				vector<char> &t = found[ std::make_pair(x, x) ];
+
+				if (t.empty())
+					t.assign(dx.size(), 1);
+
+				alone[x][a] = t[a] = 0;
+			}
+
+			__setState(x, false, blank);
+		}
+
+		for ( size_t x=0; x < n && pairwise; x++ )  {
+			const vector<T> &dx = __default_domains[x];
+
+			for ( size_t y=x+1; y < n && pairwise; y++ )  {
+				const vector<T> &dy = __default_domains[y];
+
+				for ( size_t a=0; a < dx.size() && pairwise; a++ )  {
+					__setState(x, true, dx[a]);
+
+					for ( size_t b=0; b < dy.size() && pairwise; b++ )  {
+						__setState(y, true, dy[b]);
+
+						bool accepted = __checkLegacy(k);
+
+						if (accepted && (!alone[x][a] || !alone[y][b]))
+							pairwise = false;
+						else if (!accepted && alone[x][a] && alone[y][b])  {
+							vector<char> &t = found[ std::make_pair(x, y) ];
+
+							if (t.empty())
+								t.assign(dx.size() * dy.size(), 1);
+
+							t[a * dy.size() + b] = 0;
+						}
+					}
+
+					__setState(y, false, blank);
+				}
+
+				__setState(x, false, blank);
+			}
+		}
+
+		// A constraint rejecting no value nor pair of values only rejects
+		// combinations of more variables, if any, so it is still probed
+		if (!pairwise || found.empty())
+			continue;
+
+		for ( typename std::map< std::pair<size_t, size_t>, vector<char> >::iterator it = found.begin();
+				it != found.end(); ++it )  {
+			vector<char> &t = tables[it->first];
+
+			if (t.empty())
+				t = it->second;
+			else  {
+				for ( size_t i=0; i < t.size(); i++ )
+					t[i] &= it->second[i];
+			}
+		}
+
+		if (k < nv)
+			__inferred_views.push_back(__view_constraints[k]);
+		else
+			__inferred_constraints.push_back(constraints[k - nv]);
+
+		inferred++;
+	}
+
+	for ( size_t i=0; i < n; i++ )
+		__setState(i, fixed[i], values[i]);
+
+	__synced = false;
+
+	for ( typename std::map< std::pair<size_t, size_t>, vector<char> >::iterator it = tables.begin();
+			it != tables.end(); ++it )  {
+		__inferred c;
+		c.x = it->first.first;
+		c.y = it->first.second;
+		c.allowed.swap(it->second);
+
+		vector<size_t> scope(1, c.x);
+
+		if (c.y != c.x)
+			scope.push_back(c.y);
+
+		__inferreds.push_back(c);
+		__addPropagator(&CSP<T>::__propagateInferred, __inferreds.size() - 1, scope,
+				(c.y == c.x) ? CSP_PRIORITY_UNARY : CSP_PRIORITY_BINARY, (c.y == c.x) ? 0 : CSP_EVENT_DOMAIN, true);
+		__inferred_ids.push_back(__propagators.size() - 1);
+	}
+
+	// The values removed by probing the constraints now inferred are found
+	// again by their propagators
+	__propagated = false;
+	return inferred;
+}
+
+template<class T>
+std::vector<T>
+CSP<T>::domain ( size_t index ) const
+{
+	CSPspan<T> d = domainSpan(index);
+	return vector<T>(d.begin(), d.end());
+}
+
+template<class T>
+CSPspan<T>
+CSP<T>::domainSpan ( size_t index ) const
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	return CSPspan<T>(__domain(index), __sizes[index]);
+}
+
+template<class T>
+size_t
+CSP<T>::domainSize ( size_t index ) const
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	return __sizes[index];
+}
+
+template<class T>
+CSPview<T>
+CSP<T>::view ( void ) const
+{
+	if (__values.empty())
+		return CSPview<T>(0, NULL, NULL, NULL, NULL, NULL);
+
+	return CSPview<T>(__values.size(), &__values[0], &__fixed[0], __pool.empty() ? NULL : &__pool[0],
+		&__offsets[0], &__sizes[0]);
+}
+
+template<class T>
+size_t
+CSP<T>::size( void ) const
+{
+	return __values.size();
+}
+
+template<class T>
+void
+CSP<T>::setValue ( size_t index, T value )
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	__values[index] = value;
+	__setFixed(index, true);
+	__hashValue(index);
+}
+
+template<class T>
+void
+CSP<T>::unsetValue ( size_t index )
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	if (__has_default_value)
+		__values[index] = __default_value;
+	__setFixed(index, false);
+	__hashValue(index);
+}
+
+template<class T>
+bool
+CSP<T>::isSatisfiable ( void ) const
+{
+	for ( size_t i=0; i < __sizes.size(); i++ ) {
+		if ( __sizes[i] == 0 )
+			return false;
+	}
+
+	return true;
+}
+
+template<class T>
+bool
+CSP<T>::hasUniqueSolution ( void ) const
+{
+	for ( size_t i=0; i < __sizes.size(); i++ ) {
+		if (__sizes[i] != 1)
+			return false;
+	}
+
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::assignUniqueDomains ( void )
+{
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (__sizes[i] == 1)
+			setValue( i, __domain(i)[0] );
+	}
+}
+
+template<class T>
+bool
+CSP<T>::isSet ( size_t index ) const
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	return __isFixed(index);
+}
+
+template<class T>
+const T&
+CSP<T>::value ( size_t index ) const
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	return __values[index];
+}
+
+template<class T>
+void
+CSP<T>::solve ( size_t max_iterations )
+{
+	bool   changed = false;
+	size_t steps = 1;
+	size_t iteration = 0;
+	vector< vector<T> > oldDomains(size());
+
+	__CSP_TRACE_SCOPE("solve");
+
+	do  {
+		if (max_iterations != 0)  {
+			if (steps++ > max_iterations)
+				break;
+		}
+
+		__CSP_TRACE_SCOPE("solve iteration", "iteration", iteration++);
+
+		// The vectors keep their storage from one iteration to the next
+		for ( size_t i=0; i < size(); i++ )  {
+			oldDomains[i].assign(__domain(i), __domain(i) + __sizes[i]);
+		}
+		
+		refreshDomains();
+		assignUniqueDomains();
+
+		if (!__checkpoint_file.empty())
+			__csp_checkpointer<T>::save(*this, __checkpoint_file);
+
+		if (hasUniqueSolution())
+			break;
+
+		changed = false;
+
+		for ( size_t i=0; i < size() && !changed; i++ )  {
+			if (__sizes[i] != oldDomains[i].size() ||
+					!std::equal(oldDomains[i].begin(), oldDomains[i].end(), __domain(i)))
+				changed = true;
+		}
+	} while (changed);
+}
+
+
+template<class T>
+void
+CSP<T>::setObjective ( size_t index, bool maximise )
+{
+	if (index >= __values.size())
+		throw CSPexception("Index out of range");
+
+	__objective = NULL;
+	__objective_var = index;
+	__maximise = maximise;
+}
+
+template<class T>
+void
+CSP<T>::setObjective ( double (*f)(std::vector< CSPvariable<T> >), bool maximise )
+{
+	__objective = f;
+	__objective_var = -1;
+	__maximise = maximise;
+}
+
+template<class T>
+void
+CSP<T>::setIncumbentCallback ( bool (*f)(std::vector< CSPvariable<T> >, double) )
+{
+	__incumbent_callback = f;
+}
+
+template<class T>
+double
+CSP<T>::__cost ( void )
+{
+	if (__objective_var >= 0)
+		return __csp_number(__values[__objective_var]);
+
+	return __objective(__materialise());
+}
+
+template<class T>
+bool
+CSP<T>::__improves ( double cost )
+{
+	if (!__has_incumbent)
+		return true;
+
+	return __maximise ? (cost > __incumbent) : (cost < __incumbent);
+}
+
+template<class T>
+void
+CSP<T>::__applyBound ( void )
+{
+	if (!__bounding || !__has_incumbent || __objective_var < 0)
+		return;
+
+	size_t o = __objective_var;
+	const T *domain = __domain(o);
+
+	__mask.resize(__sizes[o]);
+
+	for (size_t i=0; i < __sizes[o]; i++)
+		__mask[i] = __improves(__csp_number(domain[i]));
+
+	__narrow(o, __mask);
+}
+
+template<class T>
+bool
+CSP<T>::__consistent ( void )
+{
+	// A variable objective is already bounded through its domain, a function
+	// objective is evaluated on the partial assignment as an optimistic bound
+	if (__bounding && __has_incumbent && __objective)
+		return __improves(__cost());
+
+	return true;
+}
+
+template<class T>
+long
+CSP<T>::__selectVariable ( void )
+{
+	long best = -1;
+
+	if (__incremental)
+		return __order.empty() ? -1 : (long) __ranked[__order.begin()->second];
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (__isFixed(i))
+			continue;
+
+		if (best < 0 || __sizes[i] < __sizes[best])
+			best = i;
+	}
+
+	return best;
+}
+
+template<class T>
+bool
+CSP<T>::__onSolution ( void )
+{
+	if (__counting)  {
+		__solutions++;
+		return __solutions_limit == 0 || __solutions < __solutions_limit;
+	}
+
+	if (!__objective && __objective_var < 0)  {
+		__best = __values;
+		__has_incumbent = true;
+		return false;
+	}
+
+	double cost = __cost();
+
+	if (!__improves(cost))
+		return true;
+
+	__best = __values;
+	__incumbent = cost;
+	__has_incumbent = true;
+
+	if (__incumbent_callback)
+		return __incumbent_callback(__materialise(), cost);
+
+	return true;
+}
+
+template<class T>
+void
+CSP<T>::__save ( size_t var )
+{
+	if (!__trailing)
+		return;
+
+	__trail.push_back(__saved());
+	__trail.back().var = var;
+	__trail.back().size = __sizes[var];
+}
+
+template<class T>
+void
+CSP<T>::__reorder ( size_t var, size_t old_size )
+{
+	if (!__trailing || !__incremental || __isFixed(var))
+		return;
+
+	__order.erase( std::make_pair(old_size, __ranks[var]) );
+	__order.insert( std::make_pair(__sizes[var], __ranks[var]) );
+}
+
+template<class T>
+void
+CSP<T>::__undo ( size_t mark )
+{
+	while (__trail.size() > mark)  {
+		const __saved &s = __trail.back();
+		size_t old_size = __sizes[s.var];
+
+		__restore(s.var, s.size);
+		__reorder(s.var, old_size);
+		__trail.pop_back();
+	}
+}
+
+template<class T>
+long
+CSP<T>::__valueClass ( size_t c, T value )
+{
+	const vector<T> &cls = __value_symmetries[c];
+	typename vector<T>::const_iterator it = lower_bound(cls.begin(), cls.end(), value);
+
+	if (it == cls.end() || !(*it == value))
+		return -1;
+
+	return it - cls.begin();
+}
+
+template<class T>
+void
+CSP<T>::__startSearch ( void )
+{
+	// Without constraints over the whole set of variables the domains can be
+	// narrowed incrementally and restored from the trail on backtracking
+	__incremental = !__hasLegacyConstraints();
+	__trailing = false;
+	__order.clear();
+
+	__class_use = vector< vector<size_t> >(__value_symmetries.size());
+
+	for ( size_t c=0; c < __value_symmetries.size(); c++ )  {
+		__class_use[c].assign(__value_symmetries[c].size(), 0);
+
+		for ( size_t i=0; i < __values.size(); i++ )  {
+			long v = __isFixed(i) ? __valueClass(c, __values[i]) : -1;
+
+			if (v >= 0)
+				__class_use[c][v]++;
+		}
+	}
+
+	if (!__incremental)
+		return;
+
+	// Ties between domains of the same size are broken in favour of the most
+	// constrained variables
+	__ranked.resize(__values.size());
+	__ranks.resize(__values.size());
+
+	for ( size_t i=0; i < __values.size(); i++ )
+		__ranked[i] = i;
+
+	for ( size_t i=0; i < __values.size(); i++ )
+		__ranks[i] = __subscribers[i].size();
+
+	std::stable_sort(__ranked.begin(), __ranked.end(), __byDegree(__ranks));
+
+	for ( size_t i=0; i < __values.size(); i++ )
+		__ranks[__ranked[i]] = i;
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		if (!__isFixed(i))
+			__order.insert( std::make_pair(__sizes[i], __ranks[i]) );
+	}
+
+	__trailing = true;
+}
+
+template<class T>
+void
+CSP<T>::__assign ( size_t var, T value )
+{
+	if (__incremental)
+		__order.erase( std::make_pair(__sizes[var], __ranks[var]) );
+
+	setValue(var, value);
+
+	for ( size_t c=0; c < __value_symmetries.size(); c++ )  {
+		long v = __valueClass(c, value);
+
+		if (v >= 0)
+			__class_use[c][v]++;
+	}
+}
+
+template<class T>
+void
+CSP<T>::__unassign ( size_t var )
+{
+	if (!__isFixed(var))
+		return;
+
+	for ( size_t c=0; c < __value_symmetries.size(); c++ )  {
+		long v = __valueClass(c, __values[var]);
+
+		if (v >= 0)
+			__class_use[c][v]--;
+	}
+
+	unsetValue(var);
+
+	if (__incremental)
+		__order.insert( std::make_pair(__sizes[var], __ranks[var]) );
+}
+
+template<class T>
+bool
+CSP<T>::__propagate ( size_t var )
+{
+	if (!__incremental)  {
+		refreshDomains();
+		return isSatisfiable();
+	}
+
+	if (__bounding && __has_incumbent && __objective_var >= 0)  {
+		if (__sizes[__objective_var] == 0)
+			return false;
+
+		// The bound narrows the domain of the objective variable, which wakes
+		// up its constraints along with the ones of the assigned variable
+		__applyBound();
+
+		if (__sizes[__objective_var] == 0)  {
+			__clearQueues();
+			return false;
+		}
+	}
+
+	// Only the inconsistent states are kept, as storing the domains at each
+	// node would cost more than propagating them again
+	uint64_t key = __key();
+	bool consistent;
+
+	if (__recall(key, consistent, false) && !consistent)  {
+		__clearQueues();
+		return false;
+	}
+
+	consistent = __runPropagation(&var);
+
+	if (!consistent)
+		__remember(key, false, false);
+
+	return consistent;
+}
+
+template<class T>
+void
+CSP<T>::__search ( size_t max_nodes )
+{
+	bool consistent;
+	bool stopped = false;
+
+	__CSP_TRACE_SCOPE("search");
+
+	if (__resuming)  {
+		// The domains and the choice points come from the checkpoint
+		__resuming = false;
+		__startSearch();
+		consistent = isSatisfiable() && __consistent();
+	} else {
+		__frames.clear();
+		__trail.clear();
+		__nodes = 0;
+		refreshDomains();
+		__startSearch();
+		consistent = isSatisfiable() && __consistent();
+	}
+
+	while (true)  {
+		if (consistent)  {
+			long var = __selectVariable();
+
+			if (var < 0)  {
+				__CSP_TRACE_INSTANT("solution", "node", __nodes);
+
+				if (!__onSolution())  {
+					stopped = true;
+					break;
+				}
+			} else {
+				__frame f;
+				f.var = var;
+				f.values.assign(__domain(var), __domain(var) + __sizes[var]);
+				f.next = 0;
+				f.trail = __trail.size();
+				__breakValueSymmetries(f.values);
+				__frames.push_back(f);
+			}
+		}
+
+		// Backtrack to the deepest choice point with some values left to try
+		consistent = false;
+
+		while (!__frames.empty() && !consistent)  {
+			__frame &f = __frames.back();
+			__undo(f.trail);
+			__unassign(f.var);
+
+			if (f.next >= f.values.size())  {
+				__CSP_TRACE_INSTANT("backtrack", "depth", __frames.size());
+				__frames.pop_back();
+				continue;
+			}
+
+			if (max_nodes != 0 && __nodes >= max_nodes)  {
+				stopped = true;
+				break;
+			}
+
+			__CSP_TRACE_SCOPE("decision", "variable", f.var);
+			__nodes++;
+			__assign(f.var, f.values[f.next++]);
+
+			if (!__symmetryConsistent())
+				continue;
+
+			consistent = __propagate(f.var) && __consistent();
+
+			if (__checkpoint_every != 0 && !__checkpoint_file.empty() &&
+					__nodes % __checkpoint_every == 0)
+				__csp_checkpointer<T>::save(*this, __checkpoint_file);
+		}
+
+		if (stopped || __frames.empty())
+			break;
+	}
+
+	__undo(0);
+
+	for ( size_t i=0; i < __frames.size(); i++ )
+		unsetValue(__frames[i].var);
+
+	__frames.clear();
+	__trailing = false;
+	__incremental = false;
+	__order.clear();
+	__search_complete = !stopped;
+}
+
+template<class T>
+bool
+CSP<T>::optimise ( size_t max_nodes )
+{
+	if (__resuming && __counting)
+		throw CSPexception("The checkpoint was written by countSolutions()");
+
+	if (!__resuming)
+		__has_incumbent = false;
+
+	__bounding = true;
+	__search(max_nodes);
+	__bounding = false;
+
+	if (__has_incumbent)  {
+		for ( size_t i=0; i < __values.size(); i++ )
+			setValue(i, __best[i]);
+	}
+
+	refreshDomains();
+	return __has_incumbent;
+}
+
+template<class T>
+double
+CSP<T>::objectiveValue ( void ) const
+{
+	if (!__objective && __objective_var < 0)
+		throw CSPexception("No objective set");
+
+	if (!__has_incumbent)
+		throw CSPexception("No solution found");
+
+	return __incumbent;
+}
+
+template<class T>
+bool
+CSP<T>::isOptimal ( void ) const
+{
+	return __search_complete;
+}
+
+template<class T>
+std::vector< std::vector<size_t> >
+CSP<T>::components ( void ) const
+{
+	vector< vector<size_t> > result;
+	vector<size_t> parent(__values.size());
+	vector<long> component(__values.size(), -1);
+
+	if (__values.empty())
+		return result;
+
+	if (__hasLegacyConstraints())  {
+		result.push_back( vector<size_t>() );
+
+		for ( size_t i=0; i < __values.size(); i++ )
+			result[0].push_back(i);
+
+		return result;
+	}
+
+	// Union-find over the scopes of the constraints
+	for ( size_t i=0; i < __values.size(); i++ )
+		parent[i] = i;
+
+	for ( size_t p=1; p < __propagators.size(); p++ )  {
+		const vector<size_t> &scope = __propagators[p].scope;
+
+		if (!__propagators[p].run)
+			continue;
+
+		for ( size_t i=1; i < scope.size(); i++ )  {
+			size_t a = scope[0], b = scope[i];
+
+			while (parent[a] != a)
+				a = parent[a] = parent[parent[a]];
+
+			while (parent[b] != b)
+				b = parent[b] = parent[parent[b]];
+
+			if (a != b)
+				parent[std::max(a, b)] = std::min(a, b);
+		}
+	}
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		size_t root = i;
+
+		while (parent[root] != root)
+			root = parent[root];
+
+		if (component[root] < 0)  {
+			component[root] = result.size();
+			result.push_back( vector<size_t>() );
+		}
+
+		result[component[root]].push_back(i);
+	}
+
+	return result;
+}
+
+template<class T>
+void
+CSP<T>::__subproblem ( const std::vector<size_t> &vars, CSP<T> &sub )
+{
+	vector<long> local(__values.size(), -1);
+
+	for ( size_t i=0; i < vars.size(); i++ )
+		local[vars[i]] = i;
+
+	for ( size_t i=0; i < vars.size(); i++ )  {
+		sub.__default_domains[i] = domain(vars[i]);
+		sub.__restoreDomain(i);
+		sub.__values[i] = __values[vars[i]];
+		sub.__setFixed(i, __isFixed(vars[i]));
+	}
+
+	// The constraints over the whole set of variables make a single component
+	// of all the variables, in the same order
+	if (__hasLegacyConstraints())  {
+		sub.constraints = constraints;
+		sub.__view_constraints = __view_constraints;
+		sub.__inferred_constraints = __inferred_constraints;
+		sub.__inferred_views = __inferred_views;
+	}
+
+	// The constraints are copied with their variables renumbered, the first
+	// variable of a scope telling which component they belong to
+	for ( size_t p=1; p < __propagators.size(); p++ )  {
+		const __propagator &prop = __propagators[p];
+		vector<size_t> scope(prop.scope.size());
+		size_t data;
+
+		if (!prop.run || local[prop.scope[0]] < 0)
+			continue;
+
+		for ( size_t i=0; i < scope.size(); i++ )
+			scope[i] = local[prop.scope[i]];
+
+		if (prop.run == &CSP<T>::__propagateUnary)  {
+			sub.__unaries.push_back( std::make_pair(scope[0], __unaries[prop.data].second) );
+			data = sub.__unaries.size() - 1;
+		} else if (prop.run == &CSP<T>::__propagateBinary)  {
+			__binary b = __binaries[prop.data];
+			b.x = local[b.x];
+			b.y = local[b.y];
+			sub.__binaries.push_back(b);
+			data = sub.__binaries.size() - 1;
+		} else if (prop.run == &CSP<T>::__propagateScoped)  {
+			__scoped sc = __scopeds[prop.data];
+			sc.scope = scope;
+			sub.__scopeds.push_back(sc);
+			data = sub.__scopeds.size() - 1;
+		} else if (prop.run == &CSP<T>::__propagateInferred)  {
+			__inferred c = __inferreds[prop.data];
+			c.x = local[c.x];
+			c.y = local[c.y];
+			sub.__inferreds.push_back(c);
+			sub.__inferred_ids.push_back(sub.__propagators.size());
+			data = sub.__inferreds.size() - 1;
+		} else {
+			__expression e = __expressions[prop.data];
+			e.scope = scope;
+			sub.__expressions.push_back(e);
+			data = sub.__expressions.size() - 1;
+		}
+
+		sub.__addPropagator(prop.run, data, scope, prop.priority, prop.events, prop.idempotent);
+	}
+
+	sub.__consistency = __consistency;
+	sub.__value_symmetries = __value_symmetries;
+
+	// Only the permutations mapping the component onto itself are still
+	// symmetries of the component alone
+	for ( size_t s=0; s < __variable_symmetries.size(); s++ )  {
+		vector<size_t> permutation(vars.size());
+		bool closed = true;
+
+		for ( size_t i=0; i < vars.size() && closed; i++ )  {
+			long image = local[__variable_symmetries[s][vars[i]]];
+			closed = (image >= 0);
+			permutation[i] = closed ? image : 0;
+		}
+
+		if (closed)
+			sub.__variable_symmetries.push_back(permutation);
+	}
+
+	if (__objective_var >= 0 && local[__objective_var] >= 0)
+		sub.setObjective(local[__objective_var], __maximise);
+
+	sub.setTranspositions(__transpositions);
+}
+
+template<class T>
+void*
+CSP<T>::__solveComponents ( void *queue )
+{
+	__componentQueue *q = (__componentQueue*) queue;
+
+	while (true)  {
+		size_t next;
+
+		// Once a component has no solution, the whole CSP has none
+		pthread_mutex_lock(&q->lock);
+		next = q->failed ? q->components->size() : q->next++;
+		pthread_mutex_unlock(&q->lock);
+
+		if (next >= q->components->size())
+			break;
+
+		__CSP_TRACE_SCOPE("component", "component", next);
+		__component &c = (*q->components)[next];
+
+		// An exception must not leave the thread, where it would terminate
+		// the process: it stops the other threads as a failure does
+		try  {
+			c.found = c.csp->optimise(c.max_nodes);
+		}
+
+#if __cplusplus >= 201103L
+		catch (...)  {
+			pthread_mutex_lock(&q->lock);
+
+			if (!q->error)
+				q->error = std::current_exception();
+
+			q->failed = true;
+			pthread_mutex_unlock(&q->lock);
+			break;
+		}
+#else
+		catch (const CSPexception &e)  {
+			pthread_mutex_lock(&q->lock);
+
+			if (!q->error)
+				q->error = e.what();
+
+			q->failed = true;
+			pthread_mutex_unlock(&q->lock);
+			break;
+		}
+
+		catch (...)  {
+			pthread_mutex_lock(&q->lock);
+
+			if (!q->error)
+				q->error = "Error while solving a component";
+
+			q->failed = true;
+			pthread_mutex_unlock(&q->lock);
+			break;
+		}
+#endif
+
+		if (!c.found)  {
+			pthread_mutex_lock(&q->lock);
+			q->failed = true;
+			pthread_mutex_unlock(&q->lock);
+		}
+	}
+
+	return NULL;
+}
+
+template<class T>
+bool
+CSP<T>::solveComponents ( size_t threads, size_t max_nodes )
+{
+	vector< vector<size_t> > parts = components();
+	vector< __component > comps(parts.size());
+	std::deque< CSP<T> > subs;
+	vector<pthread_t> workers;
+	__componentQueue queue;
+	bool found = true;
+
+	if (threads == 0)
+		throw CSPexception("Invalid number of threads");
+
+	// A connected CSP is searched as it is, without copying it, and so is one
+	// with an objective function, which can't be split among the components
+	if (parts.size() == 1 || __objective)
+		return optimise(max_nodes);
+
+	// The CSPs of the components are owned by subs, whose elements never move,
+	// so they are freed however solveComponents() returns
+	for ( size_t i=0; i < parts.size(); i++ )  {
+		subs.push_back( CSP<T>(parts[i].size()) );
+		__subproblem(parts[i], subs.back());
+		comps[i].vars = parts[i];
+		comps[i].csp = &subs.back();
+		comps[i].max_nodes = max_nodes;
+		comps[i].found = false;
+	}
+
+	// The calling thread solves components as well, so it goes on alone if
+	// no other thread can be started
+	queue.components = &comps;
+	queue.next = 0;
+	queue.failed = false;
+#if __cplusplus < 201103L
+	queue.error = NULL;
+#endif
+	pthread_mutex_init(&queue.lock, NULL);
+
+	for ( size_t i=1; i < threads && i < comps.size(); i++ )  {
+		pthread_t t;
+
+		if (pthread_create(&t, NULL, __solveComponents, &queue) != 0)
+			break;
+
+		workers.push_back(t);
+	}
+
+	__solveComponents(&queue);
+
+	for ( size_t i=0; i < workers.size(); i++ )
+		pthread_join(workers[i], NULL);
+
+	pthread_mutex_destroy(&queue.lock);
+
+	if (queue.error)
+#if __cplusplus >= 201103L
+		std::rethrow_exception(queue.error);
+#else
+		throw CSPexception(queue.error);
+#endif
+
+	// Without a solution, the search is complete if some component was proved
+	// unsatisfiable; with one, if the component of the objective was searched
+	// completely, as the others stop at their first solution
+	bool complete = false, refuted = false;
+
+	for ( size_t i=0; i < comps.size(); i++ )  {
+		found = found && comps[i].found;
+		refuted = refuted || (!comps[i].found && comps[i].csp->isOptimal());
+
+		if (comps[i].csp->__objective_var >= 0)
+			complete = comps[i].csp->isOptimal();
+	}
+
+	__search_complete = found ? complete : refuted;
+	__has_incumbent = found;
+
+	// The objective, if any, is a variable of a single component, and its
+	// value is read from the merged solution
+	if (found)  {
+		for ( size_t i=0; i < comps.size(); i++ )  {
+			const CSP<T> &sub = *comps[i].csp;
+
+			for ( size_t j=0; j < comps[i].vars.size(); j++ )
+				setValue(comps[i].vars[j], sub.__values[j]);
+		}
+
+		__best = __values;
+
+		if (__objective_var >= 0)
+			__incumbent = __cost();
+
+		refreshDomains();
+	}
+
+	return found;
+}
+
+template<class T>
+uint64_t
+CSP<T>::__random ( uint64_t &state )
+{
+	// xorshift64*
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 2685821657736338717ULL;
+}
+
+template<class T>
+bool
+CSP<T>::__violated ( size_t p, std::vector<T> &tuple )
+{
+	const __propagator &prop = __propagators[p];
+
+	if (prop.run == &CSP<T>::__propagateUnary)
+		return !__unaries[prop.data].second(__values[__unaries[prop.data].first]);
+
+	if (prop.run == &CSP<T>::__propagateBinary)  {
+		const __binary &b = __binaries[prop.data];
+		char supported;
+
+		if (b.rel)
+			return !b.rel(__values[b.x], __values[b.y]);
+
+		b.support(&__values[b.x], 1, &__values[b.y], 1, true, &supported);
+		return !supported;
+	}
+
+	if (prop.run == &CSP<T>::__propagateScoped)  {
+		const __scoped &s = __scopeds[prop.data];
+		tuple.resize(s.scope.size());
+
+		for ( size_t i=0; i < s.scope.size(); i++ )
+			tuple[i] = __values[s.scope[i]];
+
+		return !s.check(tuple);
+	}
+
+	if (prop.run == &CSP<T>::__propagateInferred)  {
+		const __inferred &c = __inferreds[prop.data];
+		const vector<T> &dx = __default_domains[c.x], &dy = __default_domains[c.y];
+		size_t a = std::find(dx.begin(), dx.end(), __values[c.x]) - dx.begin();
+		size_t b = std::find(dy.begin(), dy.end(), __values[c.y]) - dy.begin();
+
+		if (a == dx.size() || b == dy.size())
+			return true;
+
+		return !c.allowed[c.x == c.y ? a : a * dy.size() + b];
+	}
+
+	const __expression &x = __expressions[prop.data];
+	tuple.resize(x.leaves.size());
+
+	for ( size_t i=0; i < x.leaves.size(); i++ )
+		tuple[i] = __values[x.scope[x.leaves[i]]];
+
+	return !x.check(&tuple[0], tuple.size(), x.constants.empty() ? NULL : &x.constants[0]);
+}
+
+template<class T>
+size_t
+CSP<T>::localSearch ( size_t max_steps, double walk, size_t tenure, uint64_t seed )
+{
+	__CSP_TRACE_SCOPE("local search", "steps", max_steps);
+	const size_t none = (size_t) -1;
+	size_t n = __values.size();
+	bool legacy = __hasLegacyConstraints();
+	uint64_t state = seed * 0x9e3779b97f4a7c15ULL + 1;
+	vector<T> tuple;
+
+	// Propagators of the constraints appended on some variables, which number
+	// them, and constraints involving each variable
+	vector<size_t> props;
+	vector< vector<size_t> > involved(n);
+
+	for ( size_t p=1; p < __propagators.size(); p++ )  {
+		if (!__propagators[p].run)
+			continue;
+
+		const vector<size_t> &scope = __propagators[p].scope;
+
+		for ( size_t i=0; i < scope.size(); i++ )
+			involved[scope[i]].push_back(props.size());
+
+		props.push_back(p);
+	}
+
+	size_t count = props.size();
+
+	// Random initial assignment of the free variables, which are all marked as
+	// set while searching, so that the constraints over all the variables can
+	// be checked
+	vector<size_t> free, pos(n, 0);
+	vector<char> movable(n, 0);
+
+	for ( size_t i=0; i < n; i++ )  {
+		if (!__isFixed(i) && __sizes[i] == 0)
+			throw CSPexception("Empty domain");
+	}
+
+	for ( size_t i=0; i < n; i++ )  {
+		if (__isFixed(i))
+			continue;
+
+		free.push_back(i);
+		movable[i] = 1;
+		pos[i] = __random(state) % __sizes[i];
+		__setState(i, legacy, __domain(i)[pos[i]]);
+	}
+
+	// Violated constraints, number of them involving each variable, and free
+	// variables involved in at least one of them
+	vector<char> violated(count, 0);
+	vector<size_t> conflicts(n, 0), conflicted, where(n, none);
+	size_t total = 0;
+
+	for ( size_t c=0; c < count; c++ )  {
+		const vector<size_t> &scope = __propagators[props[c]].scope;
+
+		if (!__violated(props[c], tuple))
+			continue;
+
+		violated[c] = 1;
+		total++;
+
+		for ( size_t i=0; i < scope.size(); i++ )
+			conflicts[scope[i]]++;
+	}
+
+	for ( size_t i=0; i < free.size(); i++ )  {
+		if (conflicts[free[i]] > 0)  {
+			where[free[i]] = conflicted.size();
+			conflicted.push_back(free[i]);
+		}
+	}
+
+	// The copy of the variables for the constraints taking a vector of them is
+	// built once, and then kept up to date by each move
+	if (__hasVectorConstraints())  {
+		__materialise();
+		__synced = true;
+	}
+
+	bool legacy_violated = legacy && !__satisfied();
+	total += legacy_violated;
+
+	// Step until which each value of each domain is tabu, indexed as the pool
+	vector<size_t> tabu(__pool.size(), 0);
+	vector<T> best(__values);
+	vector<size_t> changed;
+	size_t best_total = total;
+
+	for ( size_t step=1; step <= max_steps && best_total > 0 && !free.empty(); step++ )  {
+		// Only the constraints over all the variables may be violated
+		size_t var = conflicted.empty() ?
+			free[__random(state) % free.size()] :
+			conflicted[__random(state) % conflicted.size()];
+		const T *domain = __domain(var);
+		size_t size = __sizes[var];
+		T current = __values[var];
+		size_t choice = none;
+
+		if ((__random(state) >> 11) * (1.0 / 9007199254740992.0) < walk)
+			choice = __random(state) % size;
+		else  {
+			long best_delta = 0;
+			size_t ties = 0;
+
+			for ( size_t k=0; k < size; k++ )  {
+				if (k == pos[var])
+					continue;
+
+				long delta = 0;
+				__values[var] = domain[k];
+
+				for ( size_t i=0; i < involved[var].size(); i++ )  {
+					size_t c = involved[var][i];
+					delta += (long) __violated(props[c], tuple) - violated[c];
+				}
+
+				if (legacy)  {
+					__setState(var, true, domain[k]);
+					delta += (long) !__satisfied() - legacy_violated;
+				}
+
+				__setState(var, legacy, current);
+
+				// Aspiration: a tabu value is taken anyway if it gives the best
+				// assignment found so far
+				if (tabu[__offsets[var] + k] > step && (long) total + delta >= (long) best_total)
+					continue;
+
+				if (ties == 0 || delta < best_delta)  {
+					best_delta = delta;
+					choice = k;
+					ties = 1;
+				} else if (delta == best_delta && __random(state) % ++ties == 0)
+					choice = k;
+			}
+		}
+
+		if (choice == none || choice == pos[var])
+			continue;
+
+		tabu[__offsets[var] + pos[var]] = step + tenure;
+		pos[var] = choice;
+		__setState(var, legacy, domain[choice]);
+
+		if (changed.size() <= n)
+			changed.push_back(var);
+
+		for ( size_t i=0; i < involved[var].size(); i++ )  {
+			size_t c = involved[var][i];
+			const vector<size_t> &scope = __propagators[props[c]].scope;
+			char now = __violated(props[c], tuple);
+
+			if (now == violated[c])
+				continue;
+
+			violated[c] = now;
+
+			if (now)
+				total++;
+			else
+				total--;
+
+			for ( size_t j=0; j < scope.size(); j++ )  {
+				size_t v = scope[j];
+
+				if (now)
+					conflicts[v]++;
+				else
+					conflicts[v]--;
+
+				if (!movable[v])
+					continue;
+
+				if (conflicts[v] > 0 && where[v] == none)  {
+					where[v] = conflicted.size();
+					conflicted.push_back(v);
+				} else if (conflicts[v] == 0 && where[v] != none)  {
+					where[conflicted.back()] = where[v];
+					conflicted[where[v]] = conflicted.back();
+					conflicted.pop_back();
+					where[v] = none;
+				}
+			}
+		}
+
+		if (legacy)  {
+			total -= legacy_violated;
+			legacy_violated = !__satisfied();
+			total += legacy_violated;
+		}
+
+		// The best assignment is only updated for the variables moved since
+		// it was last found, unless they are too many to be tracked
+		if (total < best_total)  {
+			if (changed.size() > n)
+				best = __values;
+			else  {
+				for ( size_t i=0; i < changed.size(); i++ )
+					best[changed[i]] = __values[changed[i]];
+			}
+
+			changed.clear();
+			best_total = total;
+		}
+	}
+
+	__synced = false;
+
+	for ( size_t i=0; i < n; i++ )
+		setValue(i, best[i]);
+
+	return best_total;
+}
+
+template<class T>
+void
+CSP<T>::addInterchangeableValues ( std::vector<T> values )
+{
+	sort(values.begin(), values.end());
+	values.erase( unique(values.begin(), values.end()), values.end() );
+
+	if (values.size() > 1)
+		__value_symmetries.push_back(values);
+}
+
+template<class T>
+void
+CSP<T>::addVariableSymmetry ( const std::vector<size_t> &permutation )
+{
+	vector<bool> seen(__values.size(), false);
+
+	if (permutation.size() != __values.size())
+		throw CSPexception("Invalid permutation");
+
+	for ( size_t i=0; i < permutation.size(); i++ )  {
+		if (permutation[i] >= __values.size() || seen[permutation[i]])
+			throw CSPexception("Invalid permutation");
+
+		seen[permutation[i]] = true;
+	}
+
+	__variable_symmetries.push_back(permutation);
+}
+
+template<class T>
+void
+CSP<T>::clearSymmetries ( void )
+{
+	__value_symmetries.clear();
+	__variable_symmetries.clear();
+}
+
+template<class T>
+void
+CSP<T>::__breakValueSymmetries ( std::vector<T> &values )
+{
+	// With interchangeable values only, all the values of a class not used yet
+	// by any set variable are equivalent, and it's enough to try one of them.
+	// This is not compatible with the lex-leader constraints of the variable
+	// symmetries, which are complemented by value precedence instead
+	if (!__variable_symmetries.empty())
+		return;
+
+	for ( size_t c=0; c < __value_symmetries.size(); c++ )  {
+		bool kept = false;
+		vector<T> broken;
+
+		for ( size_t i=0; i < values.size(); i++ )  {
+			long v = __valueClass(c, values[i]);
+
+			if (v >= 0 && __class_use[c][v] == 0)  {
+				if (kept)
+					continue;
+
+				kept = true;
+			}
+
+			broken.push_back(values[i]);
+		}
+
+		values = broken;
+	}
+}
+
+template<class T>
+bool
+CSP<T>::__symmetryConsistent ( void )
+{
+	if (__variable_symmetries.empty())
+		return true;
+
+	// Value precedence: a value of an interchangeable class can't appear before
+	// all the smaller values of the class have appeared. Only the leading run
+	// of set variables can be checked
+	for ( size_t c=0; c < __value_symmetries.size(); c++ )  {
+		const vector<T> &cls = __value_symmetries[c];
+		size_t used = 0;
+
+		for ( size_t i=0; i < __values.size() && __isFixed(i); i++ )  {
+			typename vector<T>::const_iterator it = lower_bound(cls.begin(), cls.end(), __values[i]);
+
+			if (it == cls.end() || !(*it == __values[i]))
+				continue;
+
+			if ((size_t) (it - cls.begin()) > used)
+				return false;
+
+			if ((size_t) (it - cls.begin()) == used)
+				used++;
+		}
+	}
+
+	// Lex-leader: the assignment must not be greater than its permuted image
+	for ( size_t p=0; p < __variable_symmetries.size(); p++ )  {
+		const vector<size_t> &perm = __variable_symmetries[p];
+
+		for ( size_t i=0; i < __values.size(); i++ )  {
+			const T &x = __values[i], &y = __values[perm[i]];
+
+			if (!__isFixed(i) || !__isFixed(perm[i]) || x < y)
+				break;
+
+			if (y < x)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+template<class T>
+size_t
+CSP<T>::countSolutions ( size_t limit )
+{
+	if (__resuming && !__counting)
+		throw CSPexception("The checkpoint was written by optimise()");
+
+	if (!__resuming)
+		__solutions = 0;
+
+	__counting = true;
+	__solutions_limit = limit;
+	__search(0);
+	__counting = false;
+
+	refreshDomains();
+	return __solutions;
+}
+
+template<class T>
+void
+CSP<T>::setCheckpoint ( const std::string &file, size_t every )
+{
+#if __cplusplus >= 201103L
+	static_assert(std::is_trivially_copyable<T>::value,
+		"checkpoints can only be written for trivially copyable types");
+#endif
+
+	__checkpoint_file = file;
+	__checkpoint_every = every;
+}
+
+/**
+ * \brief  Round a section offset up to a multiple of 8 bytes, so the arrays can
+ *         be read in place from the mapped file
+ */
+static inline uint64_t
+__snapshot_align ( uint64_t offset )
+{
+	return (offset + 7) & ~((uint64_t) 7);
+}
+
+/**
+ * \brief  Check that a section of count elements of the given size, starting at
+ *         offset, is aligned and lies within a file of file_size bytes
+ */
+static inline bool
+__snapshot_fits ( uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size )
+{
+	return offset % 8 == 0 && offset <= file_size && count <= (file_size - offset) / size;
+}
+
+template<class T>
+void
+CSP<T>::checkpoint ( const std::string &file )
+{
+#if __cplusplus >= 201103L
+	static_assert(std::is_trivially_copyable<T>::value,
+		"checkpoints can only be written for trivially copyable types");
+#endif
+
+	__snapshot_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "CSPSNAP", 8);
+	h.version = 3;
+	h.value_size = sizeof(T);
+	h.variables = __values.size();
+	h.frames = __frames.size();
+	h.nodes = __nodes;
+	h.solutions = __solutions;
+	h.counting = __counting;
+	h.has_incumbent = __has_incumbent && !__best.empty();
+	h.incumbent = __incumbent;
+
+	// The whole slices are saved, with the values removed from the domains
+	// that the trail gives back on backtracking
+	for ( size_t i=0; i < __values.size(); i++ )
+		h.pool_size += __capacities[i];
+
+	for ( size_t i=0; i < __frames.size(); i++ )
+		h.frame_pool_size += __frames[i].values.size();
+
+	h.trail = __trail.size();
+
+	h.variables_offset  = __snapshot_align(sizeof(h));
+	h.values_offset     = __snapshot_align(h.variables_offset + h.variables * sizeof(__snapshot_variable));
+	h.pool_offset       = __snapshot_align(h.values_offset + h.variables * sizeof(T));
+	h.positions_offset  = __snapshot_align(h.pool_offset + h.pool_size * sizeof(T));
+	h.frames_offset     = __snapshot_align(h.positions_offset + h.pool_size * sizeof(uint32_t));
+	h.frame_pool_offset = __snapshot_align(h.frames_offset + h.frames * sizeof(__snapshot_frame));
+	h.trail_offset      = __snapshot_align(h.frame_pool_offset + h.frame_pool_size * sizeof(T));
+	h.best_offset       = __snapshot_align(h.trail_offset + h.trail * sizeof(__snapshot_saved));
+	h.file_size         = h.best_offset + (h.has_incumbent ? h.variables * sizeof(T) : 0);
+
+	vector<char> buf(h.file_size, 0);
+	__snapshot_variable *vars = (__snapshot_variable*) &buf[h.variables_offset];
+	__snapshot_frame *frames = (__snapshot_frame*) &buf[h.frames_offset];
+	T *values = (T*) &buf[h.values_offset];
+	T *pool = (T*) &buf[h.pool_offset];
+	uint32_t *positions = (uint32_t*) &buf[h.positions_offset];
+	T *frame_pool = (T*) &buf[h.frame_pool_offset];
+	__snapshot_saved *trail = (__snapshot_saved*) &buf[h.trail_offset];
+	uint64_t offset = 0;
+
+	memcpy(&buf[0], &h, sizeof(h));
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		vars[i].domain_offset = offset;
+		vars[i].domain_size = __sizes[i];
+		vars[i].slice_size = __capacities[i];
+		vars[i].fixed = __isFixed(i);
+		memcpy((void*) (values + i), &__values[i], sizeof(T));
+
+		if (__capacities[i] > 0)  {
+			memcpy((void*) (pool + offset), __domain(i), __capacities[i] * sizeof(T));
+			memcpy(positions + offset, &__positions[__offsets[i]], __capacities[i] * sizeof(uint32_t));
+		}
+
+		offset += __capacities[i];
+	}
+
+	offset = 0;
+
+	for ( size_t i=0; i < __frames.size(); i++ )  {
+		frames[i].var = __frames[i].var;
+		frames[i].next = __frames[i].next;
+		frames[i].values_offset = offset;
+		frames[i].values_size = __frames[i].values.size();
+		frames[i].trail = __frames[i].trail;
+
+		if (!__frames[i].values.empty())
+			memcpy((void*) (frame_pool + offset), &__frames[i].values[0], __frames[i].values.size() * sizeof(T));
+		offset += __frames[i].values.size();
+	}
+
+	for ( size_t i=0; i < __trail.size(); i++ )  {
+		trail[i].var = __trail[i].var;
+		trail[i].size = __trail[i].size;
+	}
+
+	if (h.has_incumbent)
+		memcpy(&buf[h.best_offset], &__best[0], h.variables * sizeof(T));
+
+	// Write a temporary file and rename it, so a crash while writing never
+	// leaves a broken checkpoint in place of the previous one
+	std::string tmp = file + ".tmp";
+	int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (fd < 0)
+		throw CSPexception("Unable to write the checkpoint file");
+
+	for ( size_t written = 0; written < buf.size(); )  {
+		ssize_t n = write(fd, &buf[written], buf.size() - written);
+
+		if (n <= 0)  {
+			close(fd);
+			throw CSPexception("Unable to write the checkpoint file");
+		}
+
+		written += n;
+	}
+
+	fsync(fd);
+	close(fd);
+
+	if (rename(tmp.c_str(), file.c_str()) != 0)
+		throw CSPexception("Unable to write the checkpoint file");
+}
+
+template<class T>
+const char*
+CSP<T>::__snapshotError ( const char *base, uint64_t size ) const
+{
+	const __snapshot_header *h = (const __snapshot_header*) base;
+	size_t n = __values.size();
+
+	if (memcmp(h->magic, "CSPSNAP", 8) != 0 || h->version != 3 || h->file_size != size)
+		return "Invalid checkpoint file";
+
+	if (h->value_size != sizeof(T) || h->variables != n)
+		return "The checkpoint was written by a different CSP";
+
+	if (!__snapshot_fits(h->variables_offset, n, sizeof(__snapshot_variable), size) ||
+			!__snapshot_fits(h->values_offset, n, sizeof(T), size) ||
+			!__snapshot_fits(h->pool_offset, h->pool_size, sizeof(T), size) ||
+			!__snapshot_fits(h->positions_offset, h->pool_size, sizeof(uint32_t), size) ||
+			!__snapshot_fits(h->frames_offset, h->frames, sizeof(__snapshot_frame), size) ||
+			!__snapshot_fits(h->frame_pool_offset, h->frame_pool_size, sizeof(T), size) ||
+			!__snapshot_fits(h->trail_offset, h->trail, sizeof(__snapshot_saved), size) ||
+			(h->has_incumbent && !__snapshot_fits(h->best_offset, n, sizeof(T), size)))
+		return "Invalid checkpoint file";
+
+	const __snapshot_variable *vars = (const __snapshot_variable*) (base + h->variables_offset);
+	const __snapshot_frame *frames = (const __snapshot_frame*) (base + h->frames_offset);
+	const uint32_t *positions = (const uint32_t*) (base + h->positions_offset);
+	const __snapshot_saved *trail = (const __snapshot_saved*) (base + h->trail_offset);
+	vector<char> seen;
+
+	// Each slice within the pool and holding the whole domain given to
+	// setDomain(), the domain no larger than that, and the positions of its
+	// values a permutation of the positions in that domain
+	for ( size_t i=0; i < n; i++ )  {
+		size_t total = __default_domains[i].size();
+
+		if (vars[i].domain_offset > h->pool_size ||
+				vars[i].slice_size > h->pool_size - vars[i].domain_offset ||
+				vars[i].slice_size < total ||
+				vars[i].domain_size > total ||
+				vars[i].fixed > 1)
+			return "Invalid checkpoint file";
+
+		seen.assign(total, 0);
+
+		for ( size_t j=0; j < total; j++ )  {
+			uint32_t p = positions[vars[i].domain_offset + j];
+
+			if (p >= total || seen[p])
+				return "Invalid checkpoint file";
+
+			seen[p] = 1;
+		}
+	}
+
+	for ( size_t i=0; i < h->frames; i++ )  {
+		if (frames[i].var >= n ||
+				frames[i].values_offset > h->frame_pool_size ||
+				frames[i].values_size > h->frame_pool_size - frames[i].values_offset ||
+				frames[i].next > frames[i].values_size ||
+				frames[i].trail > h->trail)
+			return "Invalid checkpoint file";
+	}
+
+	for ( size_t i=0; i < h->trail; i++ )
+		if (trail[i].var >= n || trail[i].size > __default_domains[trail[i].var].size())
+			return "Invalid checkpoint file";
+
+	return NULL;
+}
+
+template<class T>
+void
+CSP<T>::resume ( const std::string &file )
+{
+#if __cplusplus >= 201103L
+	static_assert(std::is_trivially_copyable<T>::value,
+		"checkpoints can only be read for trivially copyable types");
+#endif
+
+	struct stat st;
+	int fd = open(file.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		throw CSPexception("Unable to read the checkpoint file");
+
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(__snapshot_header))  {
+		close(fd);
+		throw CSPexception("Invalid checkpoint file");
+	}
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+		throw CSPexception("Unable to read the checkpoint file");
+
+	const char *base = (const char*) map;
+	const __snapshot_header *h = (const __snapshot_header*) base;
+	const char *error = __snapshotError(base, st.st_size);
+
+	// Nothing is changed until the whole file has been checked
+	if (error)  {
+		munmap(map, st.st_size);
+		throw CSPexception(error);
+	}
+
+	const __snapshot_variable *vars = (const __snapshot_variable*) (base + h->variables_offset);
+	const __snapshot_frame *frames = (const __snapshot_frame*) (base + h->frames_offset);
+	const T *values = (const T*) (base + h->values_offset);
+	const T *pool = (const T*) (base + h->pool_offset);
+	const uint32_t *positions = (const uint32_t*) (base + h->positions_offset);
+	const T *frame_pool = (const T*) (base + h->frame_pool_offset);
+	const __snapshot_saved *trail = (const __snapshot_saved*) (base + h->trail_offset);
+
+	for ( size_t i=0; i < __values.size(); i++ )  {
+		__allocate(i, vars[i].slice_size);
+		std::copy(pool + vars[i].domain_offset, pool + vars[i].domain_offset + vars[i].slice_size,
+			__domain(i));
+		std::copy(positions + vars[i].domain_offset, positions + vars[i].domain_offset + vars[i].slice_size,
+			__positions.begin() + __offsets[i]);
+		__sizes[i] = vars[i].domain_size;
+		__setFixed(i, vars[i].fixed);
+		__values[i] = values[i];
+	}
+
+	__frames.resize(h->frames);
+
+	for ( size_t i=0; i < __frames.size(); i++ )  {
+		__frames[i].var = frames[i].var;
+		__frames[i].next = frames[i].next;
+		__frames[i].values.assign(frame_pool + frames[i].values_offset,
+			frame_pool + frames[i].values_offset + frames[i].values_size);
+		__frames[i].trail = frames[i].trail;
+	}
+
+	__trail.resize(h->trail);
+
+	for ( size_t i=0; i < __trail.size(); i++ )  {
+		__trail[i].var = trail[i].var;
+		__trail[i].size = trail[i].size;
+	}
+
+	__resuming = !__frames.empty();
+	__nodes = h->nodes;
+	__solutions = h->solutions;
+	__counting = __resuming && h->counting;
+	__has_incumbent = h->has_incumbent;
+	__incumbent = h->incumbent;
+
+	if (__has_incumbent)  {
+		const T *best = (const T*) (base + h->best_offset);
+		__best.assign(best, best + h->variables);
+	}
+
+	munmap(map, st.st_size);
+	__rehash();
+}
+
+template<class T>
+void
+CSP<T>::setConsistency ( CSPconsistency level )
+{
+	if (level < CSP_NODE || level > CSP_SINGLETON_ARC)
+		throw CSPexception("Invalid consistency level");
+
+	__consistency = level;
+	__propagated = false;
+}
+
+template<class T>
+void
+CSP<T>::setProbeFixed ( bool fixed )
+{
+	__probe_fixed = fixed;
+	__propagated = false;
+}
+
+template<class T>
+CSPconsistency
+CSP<T>::consistency ( void ) const
+{
+	return __consistency;
+}
+
+template<class T>
+CSPstats
+CSP<T>::stats ( void ) const
+{
+	CSPstats s = __stats;
+	size_t nv = __view_constraints.size(), n = nv + constraints.size();
+	bool sorted = (__legacy_order.size() == n);
+
+	for ( size_t i=0; i < n; i++ )  {
+		size_t k = sorted ? __legacy_order[i] : i;
+
+		if (k >= nv && constraints[k - nv] == __default_constraint)
+			continue;
+
+		s.order.push_back(k);
+	}
+
+	return s;
+}
+
+template<class T>
+void
+CSP<T>::resetStats ( void )
+{
+	// The profiles of the constraints are kept, so their order isn't lost
+	__stats = CSPstats();
 }
 
@@ -25,5 +25,10 @@
 // .cpp file of the library inside your source code as well, and specify later
 // the types you're going to use this template class for
 
+#ifndef __CSPPP_INCLUDE_H
+#define __CSPPP_INCLUDE_H
+
 #include  "csp++.cpp"
 
+#endif
+
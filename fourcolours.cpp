@@ -6,7 +6,8 @@
  *    Description:  Interactively select a colour for some European countries. At each
  *    			selection, the domains of colours for remaining countries are
  *    			restricted, under the constraint "two adjacent countries cannot have
- *    			the same colour"
+ *    			the same colour". Run with -m to find instead the colouring using
+ *    			the fewest colours, or with -c to count the possible colourings
  *
  *       Complile:  g++ -IPATH/TO/csp++.h -o fourcolours fourcolours.cpp
  *        Version:  1.0
@@ -40,6 +41,7 @@ typedef enum  {
 
 #define 	COUNTRIES 	11
 #define 	COLOURS 		4
+#define 	BORDERS 		18
 
 static const char* countries[COUNTRIES] = {
 	"Italy", "Switz.", "Denmark", "Germany", "Austria", "France", "Belgium", "Spain", "Portugal", "Luxemb.", "Holland",
@@ -50,36 +52,45 @@ static const char* colours[COLOURS] = {
 };
 
 /**
- * FUNCTION: c
+ * Pairs of adjoining countries, which must have different colours
+ */
+static const Country borders[BORDERS][2] = {
+	{ I, CH }, { I, A }, { I, F }, { A, CH }, { A, D }, { CH, D }, { CH, F }, { D, F }, { E, F },
+	{ E, P }, { B, F }, { B, D }, { B, NL }, { B, L }, { L, F }, { L, D }, { NL, D }, { DK, D },
+};
+
+/**
+ * FUNCTION: usedColours
  *
- * Constraint function, it expresses the logic of the constraint. In our case,
- * the adjoining countries must have different colours. Each colours condition
- * is verified only if both the values have been set ("fixed" field in CSPvariable
- * structure), in our case by the user, in order to avoid an inconstistent CSP
- * from random values found inside of the variables before the initialization
+ * Objective function, it counts how many different colours have been assigned
+ * to the countries. On a partial assignment it counts the colours used so far,
+ * which can only grow when more countries are coloured
+ */
+double
+usedColours ( std::vector< CSPvariable<Colour> > variables)  {
+	bool used[COLOURS] = { false };
+	int count = 0;
+
+	for ( size_t i=0; i < variables.size(); i++ )  {
+		if (variables[i].fixed && !used[variables[i].value])  {
+			used[variables[i].value] = true;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * FUNCTION: printIncumbent
+ *
+ * Callback invoked by the optimisation each time a colouring using fewer
+ * colours is found
  */
 bool
-c ( std::vector< CSPvariable<Colour> > variables)  {
-	return (
-			( !(variables[I] .fixed || variables[CH].fixed) || (variables[I] .value != variables[CH].value) ) &&
-			( !(variables[I] .fixed || variables[A] .fixed) || (variables[I] .value != variables[A] .value) ) &&
-			( !(variables[I] .fixed || variables[F] .fixed) || (variables[I] .value != variables[F] .value) ) &&
-			( !(variables[A] .fixed || variables[CH].fixed) || (variables[A] .value != variables[CH].value) ) &&
-			( !(variables[A] .fixed || variables[D] .fixed) || (variables[A] .value != variables[D] .value) ) &&
-			( !(variables[CH].fixed || variables[D] .fixed) || (variables[CH].value != variables[D] .value) ) &&
-			( !(variables[CH].fixed || variables[F] .fixed) || (variables[CH].value != variables[F] .value) ) &&
-			( !(variables[D] .fixed || variables[F] .fixed) || (variables[D] .value != variables[F] .value) ) &&
-			( !(variables[E] .fixed || variables[F] .fixed) || (variables[E] .value != variables[F] .value) ) &&
-			( !(variables[E] .fixed || variables[P] .fixed) || (variables[E] .value != variables[P] .value) ) &&
-			( !(variables[B] .fixed || variables[F] .fixed) || (variables[B] .value != variables[F] .value) ) &&
-			( !(variables[B] .fixed || variables[D] .fixed) || (variables[B] .value != variables[D] .value) ) &&
-			( !(variables[B] .fixed || variables[NL].fixed) || (variables[B] .value != variables[NL].value) ) &&
-			( !(variables[B] .fixed || variables[L] .fixed) || (variables[B] .value != variables[L] .value) ) &&
-			( !(variables[L] .fixed || variables[F] .fixed) || (variables[L] .value != variables[F] .value) ) &&
-			( !(variables[L] .fixed || variables[D] .fixed) || (variables[L] .value != variables[D] .value) ) &&
-			( !(variables[NL].fixed || variables[D] .fixed) || (variables[NL].value != variables[D] .value) ) &&
-			( !(variables[DK].fixed || variables[D] .fixed) || (variables[DK].value != variables[D] .value) )
-		);
+printIncumbent ( std::vector< CSPvariable<Colour> >, double cost )  {
+	cout << "Found a colouring with " << cost << " colours\n";
+	return true;
 }
 
 /**
@@ -88,14 +99,16 @@ c ( std::vector< CSPvariable<Colour> > variables)  {
  * Given the CSP and the index of the variable, prints its allowed domain
  */
 void
-printDomain (CSP<Colour> csp, int variable)
+printDomain (const CSP<Colour> &csp, int variable)
 {
+	CSPspan<Colour> domain = csp.domainSpan(variable);
+
 	cout << "[ ";
 
-	for ( size_t i=0; i < csp.domain(variable).size(); i++ ) {
-		cout << colours[csp.domain(variable)[i]];
+	for ( size_t i=0; i < domain.size(); i++ ) {
+		cout << colours[domain[i]];
 
-		if ( i < csp.domain(variable).size() - 1 )
+		if ( i < domain.size() - 1 )
 			cout << ", ";
 	}
 
@@ -108,7 +121,7 @@ printDomain (CSP<Colour> csp, int variable)
  * Given the CSP, prints the domains of all the variables
  */
 void
-printDomains (CSP<Colour> csp)
+printDomains (const CSP<Colour> &csp)
 {
 	for ( size_t i=0; i < csp.size(); i++)  {
 		cout << "Domain for variable '" << countries[i] << "':\t";
@@ -152,9 +165,11 @@ getIndexByColour ( const char* colour )
  * if the given value is consistent to the domain of that variable
  */
 bool
-valueOK ( CSP<Colour> csp, size_t variable, Colour value )  {
-	for ( size_t i=0; i < csp.domain(variable).size(); i++ ) {
-		if (csp.domain(variable)[i] == value)
+valueOK ( const CSP<Colour> &csp, size_t variable, Colour value )  {
+	CSPspan<Colour> domain = csp.domainSpan(variable);
+
+	for ( size_t i=0; i < domain.size(); i++ ) {
+		if (domain[i] == value)
 			return true;
 	}
 
@@ -170,21 +185,54 @@ main ( int argc, char *argv[] )
 	for ( int i=0; i < COLOURS; i++)
 		domain.push_back((Colour) i);
 
-	// The CSP will contain as many variables as the number of countries,
-	// applying the logical constraint specified in "c" function
-	CSP<Colour> csp(COUNTRIES, c);
+	// The CSP will contain as many variables as the number of countries
+	CSP<Colour> csp(COUNTRIES);
 
 	// Set the domain for the variables
 	for ( size_t i=0; i < COUNTRIES; i++ )
 		csp.setDomain(i, domain);
 
+	// Two adjoining countries cannot have the same colour
+	for ( size_t i=0; i < BORDERS; i++ )
+		csp.appendConstraint( CSPvar<Colour>(borders[i][0]) != CSPvar<Colour>(borders[i][1]) );
+
+	// The colours are interchangeable: any permutation of the colours of a
+	// valid colouring is still a valid colouring
+	csp.addInterchangeableValues(domain);
+
+	// With -c, just count the colourings that are different up to a
+	// permutation of the colours
+	if (argc > 1 && !strcmp(argv[1], "-c"))  {
+		cout << "Number of colourings (up to a permutation of the colours): "
+			<< csp.countSolutions() << endl;
+		return EXIT_SUCCESS;
+	}
+
+	// With -m, just look for the colouring using the fewest colours
+	if (argc > 1 && !strcmp(argv[1], "-m"))  {
+		csp.setObjective(usedColours);
+		csp.setIncumbentCallback(printIncumbent);
+
+		if (!csp.optimise())  {
+			cout << "The CSP does not have a solution\n";
+			return EXIT_FAILURE;
+		}
+
+		cout << endl << "Minimum number of colours: " << csp.objectiveValue() << endl;
+
+		for ( size_t i=0; i < COUNTRIES; i++ )
+			cout << countries[i] << ":\t" << colours[csp.value(i)] << endl;
+
+		return EXIT_SUCCESS;
+	}
+
 	// Repeat until we don't find a unique solution for the CSP
 	while (!csp.hasUniqueSolution())  {
 		for ( size_t i=0; i < COUNTRIES && !csp.hasUniqueSolution(); i++ )  {
 			bool satisfiable = true;
 
 			// If a variable has an empty domain, something went wrong
-			if (csp.domain(i).size() == 0)  {
+			if (csp.domainSize(i) == 0)  {
 				cout << "No values left for country " << countries[i]
 					<< ", the domain was probably too small (few colours) or the problem is unsatisfiable\n";
 				return EXIT_FAILURE;
@@ -192,9 +240,11 @@ main ( int argc, char *argv[] )
 
 			// If a variable has a domain containing an only element,
 			// just choose it without annoying the user
-			if (csp.domain(i).size() == 1)  {
-				cout << "Setting colour " << colours[csp.domain(i)[0]] << " for " << countries[i] << endl;
-				csp.setValue( i, csp.domain(i)[0] );
+			if (csp.domainSize(i) == 1)  {
+				Colour colour = csp.domainSpan(i)[0];
+
+				cout << "Setting colour " << colours[colour] << " for " << countries[i] << endl;
+				csp.setValue( i, colour );
 				csp.refreshDomains();
 				continue;
 			}
@@ -0,0 +1,778 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  solverd.cpp
+ *
+ *    Description:  Resident solver service. Requests are read one per line, either
+ *                  from the standard input or from the clients connected to a Unix
+ *                  domain socket, and solved on a pool of worker threads, so that
+ *                  many requests are in progress at once. Each request is answered
+ *                  by a JSON object on a single line, carrying the id of the request,
+ *                  as soon as it is solved (i.e. not necessarily in order).
+ *
+ *                  The constraint structure of each model (the domains and the
+ *                  constraints of a sudoku of a given size, or the colouring of a
+ *                  graph with a given number of colours) is built once and kept in
+ *                  memory, and each request is solved on a copy of it.
+ *
+ *                  Requests:
+ *
+ *                  <id> sudoku <cells> [nodes=N]
+ *                      Solve a sudoku of n^2 x n^2 cells, given row by row either as
+ *                      a string of digits ('0' or '.' for the empty cells) or as a
+ *                      list of numbers separated by commas
+ *
+ *                  <id> colour <graph.col> [colours=K] [nodes=N]
+ *                      Colour the graph in the given DIMACS file, a path relative
+ *                      to the graph directory, with K colours or, if K is not
+ *                      given, with the fewest colours found within the node limit
+ *
+ *                  Each search can explore, besides one node for each variable, at
+ *                  most N further nodes (default: no limit). Sudokus larger than
+ *                  MAX_ORDER^2 x MAX_ORDER^2 and graphs with more than MAX_VERTICES
+ *                  vertices are refused, and a client sending a line longer than
+ *                  MAX_LINE bytes is disconnected.
+ *
+ *          Usage:  ./solverd [-t threads] [-s socket] [-g graph_dir]
+ *       Complile:  g++ -IPATH/TO/csp++.h -pthread -o solverd solverd.cpp
+ *        Version:  1.0
+ *        Created:  18/10/2026 23:14:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<iostream>
+#include	<sstream>
+#include	<string>
+#include	<vector>
+#include	<deque>
+#include	<map>
+#include	<set>
+#include	<new>
+#include	<exception>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<cstring>
+#include	<csignal>
+#include	<cerrno>
+#include	<pthread.h>
+#include	<climits>
+#include	<unistd.h>
+#include	<sys/time.h>
+#include	<sys/socket.h>
+#include	<sys/un.h>
+#include	<csp++/csp++.h>
+#include	<csp++/csp++-dimacs.h>
+#include	<csp++/csp++-grid.h>
+
+#define 	DEFAULT_THREADS 	4
+#define 	MAX_MODELS 	64
+#define 	MAX_LINE 	(1 << 20)
+#define 	MAX_ORDER 	8
+#define 	MAX_VERTICES 	100000
+
+using namespace std;
+
+/**
+ * Source of requests: the standard input (fd = -1) or a client of the socket.
+ * It is released when its requests are over and all of them have been answered
+ */
+struct Client  {
+	int fd;
+	size_t pending;
+	bool closed;
+	pthread_mutex_t lock;
+};
+
+struct Request  {
+	Client *client;
+	string line;
+};
+
+deque<Request> requests;
+bool stopping = false;
+pthread_mutex_t requests_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t requests_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Objects built on demand and kept in memory, by key. Each one is built by the
+ * first request asking for it, outside the lock, while the keys being built are
+ * kept in building so that the other requests asking for them wait instead of
+ * building them again. At most MAX_MODELS of them are kept, dropping the oldest
+ */
+template<class V>
+struct Cache  {
+	map<string, V*> items;
+	deque<string> order;
+	set<string> building;
+};
+
+Cache< CSP<int> > models;
+Cache<CSPgraph> graphs;
+pthread_mutex_t models_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t models_cond = PTHREAD_COND_INITIALIZER;
+
+string graph_dir = ".";
+
+/**
+ * FUNCTION: now
+ *
+ * Current time in seconds
+ */
+double
+now ( void )
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * FUNCTION: quote
+ *
+ * Quote a string as a JSON string literal
+ */
+string
+quote ( const string &s )
+{
+	string out = "\"";
+
+	for ( size_t i=0; i < s.size(); i++ )  {
+		unsigned char c = s[i];
+
+		if (c == '"' || c == '\\')  {
+			out += '\\';
+			out += c;
+		} else if (c < 0x20)  {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out += buf;
+		} else
+			out += c;
+	}
+
+	return out + "\"";
+}
+
+/**
+ * FUNCTION: values
+ *
+ * The values of all the variables of a solved CSP, as a JSON array
+ */
+string
+values ( const CSP<int> &csp )
+{
+	ostringstream out;
+	out << "[";
+
+	for ( size_t i=0; i < csp.size(); i++ )
+		out << (i ? "," : "") << csp.value(i);
+
+	out << "]";
+	return out.str();
+}
+
+/**
+ * FUNCTION: cached
+ *
+ * Get a copy of the object of a cache with the given key, building it through
+ * the given function the first time
+ */
+template<class V>
+V
+cached ( Cache<V> &cache, const string &key, V* (*build)(const string&), const string &arg )
+{
+	typename map<string, V*>::iterator it;
+
+	pthread_mutex_lock(&models_lock);
+
+	while ((it = cache.items.find(key)) == cache.items.end() && cache.building.count(key))
+		pthread_cond_wait(&models_cond, &models_lock);
+
+	if (it != cache.items.end())  {
+		V copy = *it->second;
+		pthread_mutex_unlock(&models_lock);
+		return copy;
+	}
+
+	cache.building.insert(key);
+	pthread_mutex_unlock(&models_lock);
+
+	V *item = NULL;
+
+	try  {
+		item = build(arg);
+	}
+
+	catch (...)  {
+		pthread_mutex_lock(&models_lock);
+		cache.building.erase(key);
+		pthread_cond_broadcast(&models_cond);
+		pthread_mutex_unlock(&models_lock);
+		throw;
+	}
+
+	pthread_mutex_lock(&models_lock);
+	cache.building.erase(key);
+
+	if (cache.items.size() >= MAX_MODELS)  {
+		delete cache.items[cache.order.front()];
+		cache.items.erase(cache.order.front());
+		cache.order.pop_front();
+	}
+
+	cache.items.insert(make_pair(key, item));
+	cache.order.push_back(key);
+
+	V copy = *item;
+	pthread_cond_broadcast(&models_cond);
+	pthread_mutex_unlock(&models_lock);
+	return copy;
+}
+
+/**
+ * FUNCTION: readGraph
+ *
+ * Read the graph in the given DIMACS file, a path relative to the graph
+ * directory which must not lead out of it
+ */
+CSPgraph*
+readGraph ( const string &file )
+{
+	char dir[PATH_MAX], path[PATH_MAX];
+
+	if (file.empty() || file[0] == '/')
+		throw CSPexception("The graph must be a path relative to the graph directory");
+
+	if (!realpath(graph_dir.c_str(), dir) || !realpath((graph_dir + "/" + file).c_str(), path))
+		throw CSPexception("Unable to read the graph file");
+
+	// Neither .. nor symbolic links can lead out of the directory
+	size_t len = strlen(dir);
+
+	if (strncmp(path, dir, len) || (path[len] != '/' && strcmp(dir, "/")))
+		throw CSPexception("The graph must be inside the graph directory");
+
+	CSPgraph *g = new CSPgraph(readDimacsGraph(path));
+
+	if (g->vertices > MAX_VERTICES)  {
+		delete g;
+		throw CSPexception("Too many vertices in the graph");
+	}
+
+	return g;
+}
+
+/**
+ * FUNCTION: buildSudoku
+ *
+ * Build a sudoku with n^2 x n^2 cells and no values, n given as a string
+ */
+CSP<int>*
+buildSudoku ( const string &arg )
+{
+	int n = atoi(arg.c_str());
+
+	if (n < 2 || n > MAX_ORDER)
+		throw CSPexception("Invalid size of the sudoku");
+
+	return new CSP<int>(CSPgrid(n).model());
+}
+
+/**
+ * FUNCTION: buildColouring
+ *
+ * Build the colouring of a graph, given as "colours:file"
+ */
+CSP<int>*
+buildColouring ( const string &arg )
+{
+	size_t sep = arg.find(':');
+	CSPgraph g = cached(graphs, arg.substr(sep+1), readGraph, arg.substr(sep+1));
+	int colours = atoi(arg.substr(0, sep).c_str());
+
+	if (colours < 1 || (size_t) colours > max(g.vertices, (size_t) 1))
+		throw CSPexception("Invalid number of colours");
+
+	return new CSP<int>(dimacsColouring(g, colours));
+}
+
+/**
+ * FUNCTION: sudoku
+ *
+ * Solve a sudoku, given as a string of digits or as numbers separated by commas
+ */
+string
+sudoku ( const string &cells, size_t max_nodes )
+{
+	vector<int> given;
+
+	if (cells.find(',') != string::npos)  {
+		istringstream in(cells);
+		string cell;
+
+		while (getline(in, cell, ','))
+			given.push_back(atoi(cell.c_str()));
+	} else {
+		for ( size_t i=0; i < cells.size(); i++ )  {
+			if (cells[i] == '.')
+				given.push_back(0);
+			else if (cells[i] >= '0' && cells[i] <= '9')
+				given.push_back(cells[i] - '0');
+			else
+				throw CSPexception("Invalid character in the sudoku");
+		}
+	}
+
+	int n = 1;
+
+	while ((size_t) (n*n*n*n) < given.size())
+		n++;
+
+	if ((size_t) (n*n*n*n) != given.size() || n < 2)
+		throw CSPexception("The number of cells of the sudoku is not n^4");
+
+	if (n > MAX_ORDER)
+		throw CSPexception("The sudoku is too large");
+
+	ostringstream key;
+	key << n;
+	CSP<int> csp = cached(models, "sudoku:" + key.str(), buildSudoku, key.str());
+
+	for ( size_t i=0; i < given.size(); i++ )  {
+		if (given[i] < 0 || given[i] > n*n)
+			throw CSPexception("Invalid value in the sudoku");
+
+		if (given[i])
+			csp.setValue(i, given[i]);
+	}
+
+	ostringstream out;
+
+	if (csp.optimise(max_nodes ? csp.size() + max_nodes : 0))
+		out << "\"status\":\"solved\",\"values\":" << values(csp);
+	else
+		out << "\"status\":\"" << (csp.isOptimal() ? "unsatisfiable" : "limit") << "\"";
+
+	return out.str();
+}
+
+/**
+ * FUNCTION: colour
+ *
+ * Colour a graph with the given number of colours or, if 0, with the fewest
+ * colours found within the node limit
+ */
+string
+colour ( const string &file, int colours, size_t max_nodes )
+{
+	CSPgraph g = cached(graphs, file, readGraph, file);
+	bool fewest = (colours == 0);
+	bool optimal = false;
+	string best;
+	int used = 0;
+
+	if (fewest)  {
+		vector<size_t> degree(g.vertices, 0);
+
+		for ( size_t i=0; i < g.edges.size(); i++ )  {
+			degree[g.edges[i].first]++;
+			degree[g.edges[i].second]++;
+		}
+
+		for ( size_t i=0; i < g.vertices; i++ )
+			colours = max(colours, (int) degree[i] + 1);
+	} else if (colours < 0)
+		throw CSPexception("Invalid number of colours");
+
+	// More colours than vertices are never needed
+	colours = min(colours, max((int) g.vertices, 1));
+
+	while (colours > 0)  {
+		ostringstream key;
+		key << colours << ":" << file;
+		CSP<int> csp = cached(models, "colour:" + key.str(), buildColouring, key.str());
+
+		if (!csp.solveComponents(1, max_nodes ? g.vertices + max_nodes : 0))  {
+			optimal = csp.isOptimal();
+			break;
+		}
+
+		vector<bool> seen(colours, false);
+		used = 0;
+
+		for ( size_t i=0; i < csp.size(); i++ )  {
+			if (!seen[csp.value(i)])  {
+				seen[csp.value(i)] = true;
+				used++;
+			}
+		}
+
+		best = values(csp);
+
+		if (!fewest)
+			break;
+
+		colours = used - 1;
+	}
+
+	ostringstream out;
+
+	if (best.empty())
+		out << "\"status\":\"" << (optimal ? "unsatisfiable" : "limit") << "\"";
+	else
+		out << "\"status\":\"solved\",\"colours\":" << used
+			<< (fewest ? (optimal ? ",\"optimal\":true" : ",\"optimal\":false") : "")
+			<< ",\"values\":" << best;
+
+	return out.str();
+}
+
+/**
+ * FUNCTION: answer
+ *
+ * Solve a request and return the JSON line answering it
+ */
+string
+answer ( const string &line )
+{
+	double start = now();
+	istringstream in(line);
+	string id, type, arg, option;
+	size_t max_nodes = 0;
+	int colours = 0;
+	ostringstream out;
+
+	in >> id >> type >> arg;
+	out << "{\"id\":" << quote(id) << ",";
+
+	try  {
+		if (arg.empty())
+			throw CSPexception("Usage: <id> sudoku <cells> | <id> colour <graph.col> [colours=K] [nodes=N]");
+
+		while (in >> option)  {
+			if (!option.compare(0, 6, "nodes="))
+				max_nodes = atol(option.c_str() + 6);
+			else if (!option.compare(0, 8, "colours="))
+				colours = atoi(option.c_str() + 8);
+			else
+				throw CSPexception("Unknown option");
+		}
+
+		if (type == "sudoku")
+			out << sudoku(arg, max_nodes);
+		else if (type == "colour")
+			out << colour(arg, colours, max_nodes);
+		else
+			throw CSPexception("Unknown request");
+	}
+
+	catch (const CSPexception &e)  {
+		out << "\"status\":\"error\",\"message\":" << quote(e.what());
+	}
+
+	catch (const std::bad_alloc&)  {
+		out << "\"status\":\"error\",\"message\":" << quote("Out of memory");
+	}
+
+	// Nothing thrown while serving a request may reach the worker thread,
+	// where it would terminate the whole service
+	catch (const std::exception &e)  {
+		out << "\"status\":\"error\",\"message\":" << quote(e.what());
+	}
+
+	catch (...)  {
+		out << "\"status\":\"error\",\"message\":" << quote("Unknown error");
+	}
+
+	out << ",\"seconds\":" << (now() - start) << "}\n";
+	return out.str();
+}
+
+/**
+ * FUNCTION: release
+ *
+ * Release a client whose requests are over and answered
+ */
+void
+release ( Client *client )
+{
+	if (client->fd >= 0)
+		close(client->fd);
+
+	pthread_mutex_destroy(&client->lock);
+	delete client;
+}
+
+/**
+ * FUNCTION: reply
+ *
+ * Send the answer to a request to its client
+ */
+void
+reply ( Client *client, const string &line )
+{
+	pthread_mutex_lock(&client->lock);
+
+	if (client->fd < 0)
+		cout << line << flush;
+	else  {
+		for ( size_t sent=0; sent < line.size(); )  {
+			ssize_t n = write(client->fd, line.data() + sent, line.size() - sent);
+
+			if (n < 0 && errno == EINTR)
+				continue;
+
+			if (n <= 0)
+				break;
+
+			sent += n;
+		}
+	}
+
+	bool done = (--client->pending == 0 && client->closed);
+	pthread_mutex_unlock(&client->lock);
+
+	if (done)
+		release(client);
+}
+
+/**
+ * FUNCTION: submit
+ *
+ * Queue a request read from a client
+ */
+void
+submit ( Client *client, const string &line )
+{
+	if (line.find_first_not_of(" \t\r") == string::npos)
+		return;
+
+	pthread_mutex_lock(&client->lock);
+	client->pending++;
+	pthread_mutex_unlock(&client->lock);
+
+	Request r;
+	r.client = client;
+	r.line = line;
+
+	pthread_mutex_lock(&requests_lock);
+	requests.push_back(r);
+	pthread_cond_signal(&requests_cond);
+	pthread_mutex_unlock(&requests_lock);
+}
+
+/**
+ * FUNCTION: finish
+ *
+ * Mark the requests of a client as over
+ */
+void
+finish ( Client *client )
+{
+	pthread_mutex_lock(&client->lock);
+	client->closed = true;
+	bool done = (client->pending == 0);
+	pthread_mutex_unlock(&client->lock);
+
+	if (done)
+		release(client);
+}
+
+/**
+ * FUNCTION: worker
+ *
+ * Thread solving the queued requests until the service is stopped
+ */
+void*
+worker ( void* )
+{
+	while (true)  {
+		pthread_mutex_lock(&requests_lock);
+
+		while (requests.empty() && !stopping)
+			pthread_cond_wait(&requests_cond, &requests_lock);
+
+		if (requests.empty())  {
+			pthread_mutex_unlock(&requests_lock);
+			break;
+		}
+
+		Request r = requests.front();
+		requests.pop_front();
+		pthread_mutex_unlock(&requests_lock);
+
+		reply(r.client, answer(r.line));
+	}
+
+	return NULL;
+}
+
+/**
+ * FUNCTION: reader
+ *
+ * Thread reading the requests of a client, one per line, from its socket or
+ * from the standard input. A line longer than MAX_LINE bytes ends the
+ * requests of the client, and its connection is closed once the requests
+ * already read are answered
+ */
+void*
+reader ( void *arg )
+{
+	Client *client = (Client*) arg;
+	int fd = (client->fd < 0) ? STDIN_FILENO : client->fd;
+	bool overflow = false;
+	string line;
+	char buf[4096];
+	ssize_t n;
+
+	while (!overflow && (n = read(fd, buf, sizeof(buf))) != 0)  {
+		if (n < 0)  {
+			if (errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		for ( ssize_t i=0; i < n; i++ )  {
+			if (buf[i] == '\n')  {
+				submit(client, line);
+				line.clear();
+			} else if (line.size() >= MAX_LINE)  {
+				overflow = true;
+				break;
+			} else
+				line += buf[i];
+		}
+	}
+
+	if (overflow)
+		cerr << "Request longer than " << MAX_LINE << " bytes, closing the connection" << endl;
+	else if (!line.empty())
+		submit(client, line);
+
+	finish(client);
+	return NULL;
+}
+
+/**
+ * FUNCTION: newClient
+ *
+ * Create the client for a file descriptor (-1 for the standard input)
+ */
+Client*
+newClient ( int fd )
+{
+	Client *client = new Client;
+	client->fd = fd;
+	client->pending = 0;
+	client->closed = false;
+	pthread_mutex_init(&client->lock, NULL);
+	return client;
+}
+
+/**
+ * FUNCTION: serve
+ *
+ * Accept the clients of a Unix domain socket, each one read by its own thread
+ */
+int
+serve ( const char *path )
+{
+	struct sockaddr_un addr;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd < 0 || strlen(path) >= sizeof(addr.sun_path))  {
+		cerr << "Unable to create the socket " << path << endl;
+		return EXIT_FAILURE;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+
+	if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0)  {
+		cerr << "Unable to listen on " << path << ": " << strerror(errno) << endl;
+		return EXIT_FAILURE;
+	}
+
+	while (true)  {
+		int client = accept(fd, NULL, NULL);
+		pthread_t thread;
+
+		if (client < 0)  {
+			if (errno == EINTR)
+				continue;
+
+			cerr << "accept: " << strerror(errno) << endl;
+			return EXIT_FAILURE;
+		}
+
+		if (pthread_create(&thread, NULL, reader, newClient(client)))  {
+			cerr << "Unable to create a thread" << endl;
+			return EXIT_FAILURE;
+		}
+
+		pthread_detach(thread);
+	}
+}
+
+int
+main ( int argc, char *argv[] )
+{
+	size_t threads = DEFAULT_THREADS;
+	const char *path = NULL;
+	int first = 1;
+
+	while (first + 1 < argc)  {
+		if (!strcmp(argv[first], "-t"))
+			threads = atol(argv[first+1]);
+		else if (!strcmp(argv[first], "-s"))
+			path = argv[first+1];
+		else if (!strcmp(argv[first], "-g"))
+			graph_dir = argv[first+1];
+		else
+			break;
+
+		first += 2;
+	}
+
+	if (first < argc || threads < 1)  {
+		cerr << "Usage: " << argv[0] << " [-t threads] [-s socket] [-g graph_dir]\n";
+		return EXIT_FAILURE;
+	}
+
+	// A client closing its connection must not kill the service
+	signal(SIGPIPE, SIG_IGN);
+
+	vector<pthread_t> workers(threads);
+
+	for ( size_t i=0; i < threads; i++ )  {
+		if (pthread_create(&workers[i], NULL, worker, NULL))  {
+			cerr << "Unable to create a thread" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (path)
+		return serve(path);
+
+	reader(newClient(-1));
+
+	pthread_mutex_lock(&requests_lock);
+	stopping = true;
+	pthread_cond_broadcast(&requests_cond);
+	pthread_mutex_unlock(&requests_lock);
+
+	for ( size_t i=0; i < threads; i++ )
+		pthread_join(workers[i], NULL);
+
+	return EXIT_SUCCESS;
+}
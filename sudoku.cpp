@@ -8,8 +8,18 @@
  *                  be found in the file sudoku.txt. If no parameters is passed to the
  *                  program, this default sudoku is loaded and solved, otherwise the
  *                  sudoku chosen by the user in the specified text file is solved.
+ *                  If a second file is given, a trace of the solver is written to
+ *                  it in Chrome Trace Event JSON format. The grid is handled by
+ *                  csp++/csp++-grid.h, so sudokus of any size are accepted.
  *
- *          Usage:  ./sudoku <text file containing the sudoku>
+ *                  With -b, the sudokus in the given files are solved many times
+ *                  each (1000 by default, change it with -n), and the average time
+ *                  taken by each resolution is printed, for using the sample files
+ *                  as a benchmark. With -t, the resolutions share a transposition
+ *                  table, so the states propagated before are looked up.
+ *
+ *          Usage:  ./sudoku [<text file containing the sudoku> [<trace file>]]
+ *                  ./sudoku -b [-n runs] [-t] <text file> [<text file> ...]
  *       Complile:  g++ -IPATH/TO/csp++.h -o sudoku sudoku.cpp
  *        Version:  1.0
  *        Created:  17/05/2010 09:22:25
@@ -24,205 +34,139 @@
  */
 
 #include	<iostream>
-#include  <fstream>
-#include  <string>
+#include	<string>
+#include	<vector>
 #include	<cstdlib>
-#include	<cmath>
+#include	<cstring>
+#include	<sys/time.h>
 #include	<csp++/csp++.h>
+#include	<csp++/csp++-grid.h>
 
-#define 	NOVALUE 	-1
 #define 	DEFAULT_SUDOKU_FILE 	"sudoku.txt"
+#define 	DEFAULT_RUNS 	1000
 
 using namespace std;
 
-int WIDTH  = 0;
-int HEIGHT = 0;
-
-int
-toID (int i, int j)
+/**
+ * FUNCTION: now
+ *
+ * Current time in seconds
+ */
+double
+now ( void )
 {
-	return (i * (WIDTH*WIDTH)) + j;
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
 }
 
-bool
-rowsConstraint ( std::vector< CSPvariable<int> > variables)
+/**
+ * FUNCTION: solveSudoku
+ *
+ * Propagate the values of the sudoku and, if some cells are still not set,
+ * search for a solution. Return the number of solutions, counting up to 2
+ */
+size_t
+solveSudoku ( CSP<int> &csp )
 {
-	for ( int i=0; i < WIDTH*WIDTH; i++ ) {
-		for ( int j=0; j < HEIGHT*HEIGHT; j++ ) {
-			for ( int k=0; k < j; k++ ) {
-				int var1 = toID(i,j);
-				int var2 = toID(i,k);
-
-				if ( variables[var1].fixed || variables[var2].fixed )  {
-					if ( variables[var1].value == variables[var2].value )  {
-						return false;
-					}
-				}
-			}
-		}
-	}
+	csp.solve();
 
-	return true;
-}
+	if (!csp.isSatisfiable())
+		return 0;
 
-bool
-colsConstraint ( std::vector< CSPvariable<int> > variables)
-{
-	for ( int i=0; i < HEIGHT*HEIGHT; i++ ) {
-		for ( int j=0; j < WIDTH*WIDTH; j++ ) {
-			for ( int k=0; k < j; k++ ) {
-				int var1 = toID(j,i);
-				int var2 = toID(k,i);
-
-				if ( variables[var1].fixed || variables[var2].fixed )  {
-					if ( variables[var1].value == variables[var2].value )  {
-						return false;
-					}
-				}
-			}
-		}
-	}
+	if (csp.hasUniqueSolution())
+		return 1;
 
-	return true;
-}
+	CSP<int> other(csp);
+	size_t solutions = other.countSolutions(2);
 
-bool
-cellsConstraint ( std::vector< CSPvariable<int> > variables)
-{
-	for ( int x=0; x < WIDTH*WIDTH; x += WIDTH )  {
-		for ( int y=0; y < HEIGHT*HEIGHT; y += HEIGHT )  {
-			for ( int i=x; i < x+WIDTH; i++ ) {
-				for ( int j=y; j < y+HEIGHT; j++ ) {
-					int var1 = toID(i,j);
-
-					for ( int k=x; k < i; k++ ) {
-						for ( int l=y; l < j; l++ ) {
-							int var2 = toID(k,l);
-
-							if ( variables[var1].fixed || variables[var2].fixed )  {
-								if ( variables[var1].value == variables[var2].value )  {
-									return false;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
-	}
+	if (solutions > 0)
+		csp.optimise();
 
-	return true;
+	return solutions;
 }
 
+/**
+ * FUNCTION: benchmark
+ *
+ * Solve the sudoku in a file the given number of times, and print the average
+ * time taken by each resolution
+ */
 void
-printSudoku (CSP<int> csp)
+benchmark ( const char *file, size_t runs, CSPtranspositions *table )
 {
-	for ( int i=0; i < WIDTH*WIDTH; i++ ) {
-		if (!(i % WIDTH))
-			cout << endl;
+	vector<int> givens;
+	CSPgrid grid = readGrid(file, givens);
+	CSP<int> empty = grid.model();
+	size_t solutions = 0, lookups = 0, hits = 0;
+	double start = now();
 
-		for ( int j=0; j < HEIGHT*HEIGHT; j++ ) {
-			int id = toID(j,i);
+	empty.setTranspositions(table);
 
-			if (!(j % HEIGHT))
-				cout << "  ";
+	for ( size_t r=0; r < runs; r++ )  {
+		CSP<int> csp(empty);
 
-			if (csp.isSet(id))
-				cout << csp.value(id) << " ";
-			else
-				cout << ". ";
+		for ( size_t c=0; c < givens.size(); c++ )  {
+			if (givens[c])
+				csp.setValue(c, givens[c]);
 		}
 
-		cout << endl;
+		solutions = solveSudoku(csp);
+		lookups += csp.stats().lookups;
+		hits += csp.stats().hits;
 	}
 
+	cout << file << ": " << grid.side() << "x" << grid.side() << ", "
+		<< (solutions == 0 ? "no solution" : (solutions == 1 ? "unique solution" : "several solutions")) << ", "
+		<< (now() - start) / runs * 1e6 << " microseconds";
+
+	if (table)
+		cout << ", " << hits << "/" << lookups << " states found in the table";
+
 	cout << endl;
 }
 
-CSP<int>
-getSudoku (const char* sudokuFile)
+int
+main ( int argc, char *argv[] )
 {
-	string line;
-	vector< vector<int> > sudoku;
-	ifstream in(sudokuFile);
-
-	if (!in)
-		throw "Unable to read input file";
-
-	for ( HEIGHT = 0; getline(in, line); HEIGHT++ )  {
-		vector<int> values;
-		string value = "";
-		bool hasNumbers = false;
-
-		for ( int j=0; j < line.length(); j++)  {
-			if (line[j] >= '0' && line[j] <= '9')  {
-				value += line[j];
-				hasNumbers = true;
-			} else {
-				if (value.length() > 0)  {
-					values.push_back( atoi(value.c_str()) );
-					value = "";
-				}
-			}
+	if (argc > 1 && !strcmp(argv[1], "-b"))  {
+		size_t runs = DEFAULT_RUNS;
+		bool transpositions = false;
+		int first = 2;
+
+		if (first + 1 < argc && !strcmp(argv[first], "-n"))  {
+			runs = atol(argv[first+1]);
+			first += 2;
 		}
 
-		if (!hasNumbers)  {
-			HEIGHT--;
-			continue;
+		if (first < argc && !strcmp(argv[first], "-t"))  {
+			transpositions = true;
+			first++;
 		}
 
-		if (value.length() > 0)  {
-			values.push_back( atoi(value.c_str()) );
-			value = "";
+		if (first >= argc || runs < 1)  {
+			cerr << "Usage: " << argv[0] << " -b [-n runs] [-t] <text file> [<text file> ...]\n";
+			return EXIT_FAILURE;
 		}
 
-		if ( HEIGHT == 0 )
-			WIDTH = values.size();
-		else  {
-			if (values.size() != WIDTH)  {
-				in.close();
-				throw "The columns have different number of elements";
-			}
-		}
-
-		sudoku.push_back(values);
-	}
+		CSPtranspositions table;
 
-	in.close();
-
-	if (HEIGHT != WIDTH)
-		throw "The grid is not a square";
-
-	WIDTH  = (int) sqrt(WIDTH);
-	HEIGHT = (int) sqrt(HEIGHT);
-	vector<int> domain;
-
-	for ( int i=1; i <= WIDTH*WIDTH; i++)
-		domain.push_back(i);
-
-	CSP<int> csp( WIDTH*WIDTH * HEIGHT*HEIGHT, NOVALUE, false);
-	csp.appendConstraint(rowsConstraint);
-	csp.appendConstraint(colsConstraint);
-	csp.appendConstraint(cellsConstraint);
-
-	for ( int i=0; i < csp.size(); i++ )
-		csp.setDomain(i, domain);
+		for ( int i=first; i < argc; i++ )  {
+			try  {
+				benchmark(argv[i], runs, transpositions ? &table : NULL);
+			}
 
-	for ( int i=0; i < sudoku.size(); i++ ) {
-		for ( int j=0; j < sudoku[i].size(); j++ ) {
-			if (sudoku[i][j] != 0)  {
-				csp.setValue( toID(j,i), sudoku[i][j] );
+			catch (const CSPexception &e)  {
+				cerr << argv[i] << ": " << e.what() << endl;
 			}
 		}
+
+		return EXIT_SUCCESS;
 	}
-	
-	return csp;
-}
 
-int
-main ( int argc, char *argv[] )
-{
 	string sudokuFile;
+	vector<int> givens;
+	CSPgrid grid;
 	CSP<int> csp;
 
 	if (argc == 1)  {
@@ -235,29 +179,44 @@ main ( int argc, char *argv[] )
 	}
 
 	try  {
-		csp = getSudoku(sudokuFile.c_str());
+		grid = readGrid(sudokuFile.c_str(), givens);
+		csp = grid.model(givens);
 		cout << "Sudoku to be solved:\n";
-		printSudoku(csp);
+		grid.print(cout, csp);
 	}
 
-	catch (const char* msg)  {
-		cerr << "Exception: " << msg << endl;
+	catch (const CSPexception &e)  {
+		cerr << "Exception: " << e.what() << endl;
 		return EXIT_FAILURE;
 	}
 
+	if (argc > 2)
+		CSPtrace::start(argv[2]);
+
 	cout << "Solving..." << endl;
-	csp.solve();
+	size_t solutions = solveSudoku(csp);
 	cout << endl;
 
-	printSudoku(csp);
+	if (argc > 2)  {
+		try  {
+			CSPtrace::stop();
+			cout << "Trace written to " << argv[2] << endl;
+		}
+
+		catch (const CSPexception &e)  {
+			cerr << "Exception: " << e.what() << endl;
+		}
+	}
+
+	grid.print(cout, csp);
 
-	if (csp.isSatisfiable())  {
+	if (solutions > 0)  {
 		cout << "This sudoku has a solution ";
 
-		if (csp.hasUniqueSolution())
+		if (solutions == 1)
 			cout << "and the solution is unique\n";
 		else
-			cout << "but it wasn't possible to determine it univocally (missing values?)\n";
+			cout << "but the solution is not unique (missing values?)\n";
 	} else
 		cout << "This sudoku does not have any solution\n";
 
@@ -0,0 +1,93 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  accessors.cpp
+ *
+ *    Description:  Tests of the zero-copy accessors: the domains read as spans and
+ *                  through views of a const CSP, against the copies returned by
+ *                  domain(), and the values read by reference
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 01:02:38
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<string>
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+// Only reads the CSP through its const interface
+static bool
+sameDomains ( const CSP<string> &csp )
+{
+	CSPview<string> view = csp.view();
+
+	for ( size_t i=0; i < csp.size(); i++ )  {
+		vector<string> copy = csp.domain(i);
+		CSPspan<string> span = csp.domainSpan(i);
+
+		if (span.size() != copy.size() || span.size() != csp.domainSize(i) || span.empty() != copy.empty())
+			return false;
+
+		if (span.begin() != view.domain(i) || span.end() != view.domain(i) + view.domainSize(i))
+			return false;
+
+		if (!equal(span.begin(), span.end(), copy.begin()))
+			return false;
+	}
+
+	return true;
+}
+
+int
+main ( void )
+{
+	vector<string> words;
+	words.push_back("alpha");
+	words.push_back("beta");
+	words.push_back("delta");
+	words.push_back("gamma");
+
+	CSP<string> csp(3);
+
+	for ( size_t i=0; i < 3; i++ )
+		csp.setDomain(i, words);
+
+	csp.appendConstraint(0, 1, CSP<string>::lessThan);
+	csp.appendConstraint(1, 2, CSP<string>::lessThan);
+	CHECK(sameDomains(csp));
+
+	csp.refreshDomains();
+	CHECK(sameDomains(csp));
+	CHECK(csp.domainSpan(0).size() == 2 && csp.domainSpan(0)[0] == "alpha");
+	CHECK(csp.domainSpan(2).size() == 2 && csp.domainSpan(2)[1] == "gamma");
+
+	// The values are read in place, without copies
+	csp.setValue(1, "beta");
+	const CSP<string> &ro = csp;
+	CHECK(&ro.value(1) == &ro.value(1));
+	CHECK(&ro.value(1) == &ro.view().value(1));
+	CHECK(ro.value(1) == "beta" && ro.isSet(1) && !ro.isSet(0));
+
+	csp.refreshDomains();
+	CHECK(sameDomains(csp));
+	CHECK(csp.domainSpan(0).size() == 1 && csp.domainSpan(0)[0] == "alpha");
+
+	// A wiped out domain is an empty span
+	csp.setValue(0, "gamma");
+	csp.refreshDomains();
+	CHECK(sameDomains(csp));
+	CHECK(!csp.isSatisfiable());
+	CHECK_THROWS(csp.domainSpan(3));
+	CHECK_EXIT();
+}
@@ -0,0 +1,51 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  check.h
+ *
+ *    Description:  Minimal assertions for the tests run by make check. A failed
+ *                  CHECK prints the file, the line and the condition, and the test
+ *                  goes on; CHECK_EXIT() returns a failure status from main() if
+ *                  any CHECK failed
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 22:31:12
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#ifndef __CSPPP_CHECK_H
+#define __CSPPP_CHECK_H
+
+#include	<iostream>
+
+static int __check_failures = 0;
+
+#define	CHECK(cond)  do  { \
+	if (!(cond))  { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #cond << std::endl; \
+		__check_failures++; \
+	} \
+} while (0)
+
+#define	CHECK_THROWS(expr)  do  { \
+	bool __thrown = false; \
+	try  { expr; } catch ( ... )  { __thrown = true; } \
+	if (!__thrown)  { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": no exception from: " << #expr << std::endl; \
+		__check_failures++; \
+	} \
+} while (0)
+
+#define	CHECK_EXIT()  do  { \
+	std::cout << __FILE__ << ": " << (__check_failures ? "FAILED" : "ok") << std::endl; \
+	return __check_failures ? 1 : 0; \
+} while (0)
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  checkpoint.cpp
+ *
+ *    Description:  Tests of checkpoint() and resume(): the state of a CSP saved and
+ *                  read back into another one, searches continued from a checkpoint
+ *                  written while they were running, and corrupt checkpoints, which
+ *                  must be rejected leaving the CSP as it was
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:08:44
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<fstream>
+#include	<string>
+#include	<vector>
+#include	<cstdio>
+#include	<stdint.h>
+#include	<unistd.h>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+// Offsets in the header of the checkpoint files, and size of the records of
+// the variables
+#define	FRAMES_COUNT      32
+#define	VARIABLES_OFFSET  88
+#define	VALUES_OFFSET     96
+#define	POSITIONS_OFFSET  112
+#define	FRAMES_OFFSET     120
+#define	TRAIL_COUNT       48
+#define	TRAIL_OFFSET      136
+#define	VARIABLE_SIZE     32
+
+static bool
+differ ( int a, int b )
+{
+	return a != b;
+}
+
+static double
+sum ( vector< CSPvariable<int> > v )
+{
+	double s = 0;
+
+	for ( size_t i=0; i < v.size(); i++ )
+		if (v[i].fixed)
+			s += v[i].value;
+
+	return s;
+}
+
+// Colourings of the path 0 - 1 - ... - 5 with the colours 1, 2 and 3
+static void
+path ( CSP<int> &csp )
+{
+	int colours[] = { 1, 2, 3 };
+
+	for ( size_t i=0; i < csp.size(); i++ )
+		csp.setDomain(i, colours, 3);
+
+	for ( size_t i=0; i+1 < csp.size(); i++ )
+		csp.appendConstraint(i, i+1, differ);
+}
+
+static string
+readFile ( const string &file )
+{
+	ifstream in(file.c_str(), ios::binary);
+	return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+static void
+writeFile ( const string &file, const string &data )
+{
+	ofstream out(file.c_str(), ios::binary | ios::trunc);
+	out.write(data.data(), data.size());
+}
+
+static uint64_t
+field ( const string &data, size_t offset )
+{
+	uint64_t v;
+	data.copy((char*) &v, sizeof(v), offset);
+	return v;
+}
+
+static string
+patch ( string data, size_t offset, uint64_t v )
+{
+	data.replace(offset, sizeof(v), string((const char*) &v, sizeof(v)));
+	return data;
+}
+
+static string
+patch32 ( string data, size_t offset, uint32_t v )
+{
+	data.replace(offset, sizeof(v), string((const char*) &v, sizeof(v)));
+	return data;
+}
+
+static bool
+sameState ( const CSP<int> &a, const CSP<int> &b )
+{
+	if (a.size() != b.size())
+		return false;
+
+	for ( size_t i=0; i < a.size(); i++ )  {
+		if (a.isSet(i) != b.isSet(i) || a.domain(i) != b.domain(i))
+			return false;
+
+		if (a.isSet(i) && a.value(i) != b.value(i))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+testRoundTrip ( const string &file )
+{
+	CSP<int> saved(6);
+	path(saved);
+	saved.setValue(0, 2);
+	saved.setValue(3, 1);
+	saved.refreshDomains();
+	saved.checkpoint(file);
+
+	CSP<int> restored(6);
+	path(restored);
+	restored.resume(file);
+	CHECK(sameState(saved, restored));
+	CHECK(restored.isSet(0) && restored.value(0) == 2);
+	CHECK(restored.domain(1).size() == 2);
+}
+
+static void
+testSearches ( const string &file )
+{
+	// 3 * 2^5 colourings; the last checkpoint is written in the middle of
+	// the search, and the search resumed from it finds the same total
+	CSP<int> counted(6);
+	path(counted);
+	counted.setCheckpoint(file, 7);
+	CHECK(counted.countSolutions() == 96);
+	CHECK(field(readFile(file), FRAMES_COUNT) > 0);
+
+	CSP<int> resumed(6);
+	path(resumed);
+	resumed.resume(file);
+	CHECK_THROWS(resumed.optimise());
+	resumed.resume(file);
+	CHECK(resumed.countSolutions() == 96);
+
+	// The same for the smallest sum of the colours, 1-2-1-2-1-2
+	CSP<int> optimised(6);
+	path(optimised);
+	optimised.setObjective(sum);
+	optimised.setCheckpoint(file, 3);
+	CHECK(optimised.optimise());
+	CHECK(optimised.objectiveValue() == 9);
+
+	CSP<int> continued(6);
+	path(continued);
+	continued.setObjective(sum);
+	continued.resume(file);
+	CHECK(continued.optimise());
+	CHECK(continued.objectiveValue() == 9);
+}
+
+static void
+testCorrupt ( const string &file )
+{
+	CSP<int> saved(6);
+	path(saved);
+	saved.setValue(2, 3);
+	saved.refreshDomains();
+	saved.checkpoint(file);
+
+	string good = readFile(file);
+	uint64_t vars = field(good, VARIABLES_OFFSET);
+	vector<string> bad;
+
+	// Truncated, and with an extra byte
+	bad.push_back(good.substr(0, good.size() - 1));
+	bad.push_back(good + '\0');
+	bad.push_back(good.substr(0, 16));
+
+	// Sections out of the file or misaligned
+	bad.push_back(patch(good, VALUES_OFFSET, good.size()));
+	bad.push_back(patch(good, VALUES_OFFSET, (uint64_t) -8));
+	bad.push_back(patch(good, VARIABLES_OFFSET, vars + 4));
+
+	// A domain larger than its slice, a slice out of the pool
+	bad.push_back(patch(good, vars + 8, field(good, vars + 16) + 1));
+	bad.push_back(patch(good, vars, (uint64_t) 1 << 40));
+
+	// More choice points than the file holds
+	bad.push_back(patch(good, FRAMES_COUNT, 1));
+
+	// Positions out of the domain given to setDomain(), or repeated
+	uint64_t positions = field(good, POSITIONS_OFFSET);
+	bad.push_back(patch32(good, positions, 3));
+	bad.push_back(patch32(good, positions + 4, field(good, positions) & 0xffffffff));
+
+	// A choice point on a variable which doesn't exist, in a checkpoint
+	// written during a search
+	CSP<int> counted(6);
+	path(counted);
+	counted.setCheckpoint(file, 5);
+	counted.countSolutions();
+
+	string searching = readFile(file);
+	bad.push_back(patch(searching, field(searching, FRAMES_OFFSET), 6));
+
+	// A domain saved on the trail larger than the one given to setDomain()
+	if (field(searching, TRAIL_COUNT) > 0)
+		bad.push_back(patch(searching, field(searching, TRAIL_OFFSET) + 8, 4));
+
+
+	CSP<int> csp(6);
+	path(csp);
+	csp.setValue(4, 1);
+	csp.refreshDomains();
+
+	CSP<int> before(6);
+	path(before);
+	before.setValue(4, 1);
+	before.refreshDomains();
+
+	for ( size_t i=0; i < bad.size(); i++ )  {
+		writeFile(file, bad[i]);
+		CHECK_THROWS(csp.resume(file));
+		CHECK(sameState(csp, before));
+	}
+
+	// A domain of 2 values in a slice of 3, saved as 3 values with a third
+	// position out of the domain
+	int colours[] = { 1, 2 };
+	CSP<int> shrunk(6);
+	path(shrunk);
+	shrunk.setDomain(0, colours, 2);
+	shrunk.checkpoint(file);
+
+	string small = readFile(file);
+	uint64_t record = field(small, VARIABLES_OFFSET);
+	uint64_t slice = field(small, POSITIONS_OFFSET) + 4 * field(small, record);
+	CHECK(field(small, record + 16) == 3);
+
+	CSP<int> same(6);
+	path(same);
+	same.setDomain(0, colours, 2);
+
+	writeFile(file, patch(small, record + 8, 3));
+	CHECK_THROWS(same.resume(file));
+	writeFile(file, patch32(patch(small, record + 8, 3), slice + 8, 100000000));
+	CHECK_THROWS(same.resume(file));
+	CHECK(same.domainSize(0) == 2);
+
+	writeFile(file, small);
+	same.resume(file);
+	CHECK(sameState(same, shrunk));
+
+	// A CSP with a different number of variables
+	writeFile(file, good);
+	CSP<int> other(5);
+	path(other);
+	CHECK_THROWS(other.resume(file));
+
+	// ... while the untouched file is still read back
+	csp.resume(file);
+	CHECK(sameState(csp, saved));
+}
+
+int
+main ( void )
+{
+	char name[] = "/tmp/csp-checkpoint-XXXXXX";
+	int fd = mkstemp(name);
+
+	if (fd < 0)
+		return 1;
+
+	close(fd);
+	testRoundTrip(name);
+	testSearches(name);
+	testCorrupt(name);
+	unlink(name);
+	CHECK_EXIT();
+}
@@ -0,0 +1,151 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  components.cpp
+ *
+ *    Description:  Tests of the decomposition into components of the constraint
+ *                  graph: the components found, and the solutions and objective
+ *                  values of solveComponents() on one and more threads
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 00:21:45
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static double
+sum ( vector< CSPvariable<int> > v )
+{
+	double s = 0;
+
+	for ( size_t i=0; i < v.size(); i++ )
+		if (v[i].fixed)
+			s += v[i].value;
+
+	return s;
+}
+
+// Two chains x0 < x2 < x4 and x1 != x3 != x5, over 1 .. 4, plus a variable
+// x6 on its own
+static void
+chains ( CSP<int> &csp )
+{
+	int values[] = { 1, 2, 3, 4 };
+
+	for ( size_t i=0; i < 7; i++ )
+		csp.setDomain(i, values, 4);
+
+	csp.appendConstraint(0, 2, CSP<int>::lessThan);
+	csp.appendConstraint(2, 4, CSP<int>::lessThan);
+	csp.appendConstraint(1, 3, CSP<int>::notEqual);
+	csp.appendConstraint(3, 5, CSP<int>::notEqual);
+}
+
+// A constraint failing with an exception as soon as it is checked
+static bool
+broken ( int, int )
+{
+	throw CSPexception("Broken constraint");
+}
+
+static bool
+valid ( const CSP<int> &csp )
+{
+	for ( size_t i=0; i < 7; i++ )
+		if (!csp.isSet(i))
+			return false;
+
+	return csp.value(0) < csp.value(2) && csp.value(2) < csp.value(4) &&
+		csp.value(1) != csp.value(3) && csp.value(3) != csp.value(5);
+}
+
+static void
+testComponents ( void )
+{
+	CSP<int> csp(7);
+	chains(csp);
+
+	vector< vector<size_t> > parts = csp.components();
+	CHECK(parts.size() == 3);
+	CHECK(parts[0].size() == 3 && parts[0][0] == 0 && parts[0][1] == 2 && parts[0][2] == 4);
+	CHECK(parts[1].size() == 3 && parts[1][0] == 1 && parts[1][1] == 3 && parts[1][2] == 5);
+	CHECK(parts[2].size() == 1 && parts[2][0] == 6);
+}
+
+static void
+testSolve ( size_t threads )
+{
+	// No objective: any solution, and no objective value
+	CSP<int> plain(7);
+	chains(plain);
+	CHECK(plain.solveComponents(threads));
+	CHECK(valid(plain));
+	CHECK_THROWS(plain.objectiveValue());
+
+	// The largest value of x4 is optimised within its component, and read
+	// back from the merged solution
+	CSP<int> var(7);
+	chains(var);
+	var.setObjective(4, true);
+	CHECK(var.solveComponents(threads));
+	CHECK(valid(var));
+	CHECK(var.isOptimal());
+	CHECK(var.objectiveValue() == 4);
+	CHECK(var.value(4) == 4);
+
+	// ... and the smallest value of x2, in the same way
+	CSP<int> low(7);
+	chains(low);
+	low.setObjective(2);
+	CHECK(low.solveComponents(threads));
+	CHECK(low.objectiveValue() == 2);
+
+	// An objective function over all the components is optimised as a whole:
+	// 1 + 2 + 3, 1 + 2 + 1, and 1
+	CSP<int> whole(7);
+	chains(whole);
+	whole.setObjective(sum);
+	CHECK(whole.solveComponents(threads));
+	CHECK(valid(whole));
+	CHECK(whole.isOptimal());
+	CHECK(whole.objectiveValue() == 11);
+
+	// A component without solutions makes the whole CSP unsatisfiable
+	CSP<int> none(7);
+	chains(none);
+	none.appendConstraint(6, 6, CSP<int>::lessThan);
+	CHECK(!none.solveComponents(threads));
+	CHECK(none.isOptimal());
+
+	// An exception thrown while solving a component is thrown again by
+	// solveComponents(), whatever the thread solving it
+	CSP<int> error(7);
+	chains(error);
+	error.appendConstraint(1, 3, broken);
+	CHECK_THROWS(error.solveComponents(threads));
+}
+
+int
+main ( void )
+{
+	testComponents();
+	testSolve(1);
+	testSolve(3);
+
+	CSP<int> csp(7);
+	chains(csp);
+	CHECK_THROWS(csp.solveComponents(0));
+	CHECK_EXIT();
+}
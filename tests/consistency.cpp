@@ -0,0 +1,151 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  consistency.cpp
+ *
+ *    Description:  Tests of the consistency levels: what node consistency, forward
+ *                  checking, arc, path and singleton arc consistency remove from the
+ *                  domains of small CSPs, and the statistics they collect
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:37:02
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static bool
+differ ( int a, int b )
+{
+	return a != b;
+}
+
+static bool
+notOne ( int a )
+{
+	return a != 1;
+}
+
+// n variables taking the colours 1 .. colours, each one different from the
+// next, and the last one from the first if closed
+static void
+ring ( CSP<int> &csp, int colours, bool closed, CSPconsistency level )
+{
+	vector<int> domain;
+
+	for ( int i=1; i <= colours; i++ )
+		domain.push_back(i);
+
+	for ( size_t i=0; i < csp.size(); i++ )
+		csp.setDomain(i, domain);
+
+	for ( size_t i=0; i+1 < csp.size(); i++ )
+		csp.appendConstraint(i, i+1, differ);
+
+	if (closed)
+		csp.appendConstraint(csp.size()-1, 0, differ);
+
+	csp.setConsistency(level);
+}
+
+static void
+testTriangle ( void )
+{
+	// A triangle can't be coloured with 2 colours, but each value has a
+	// support on each edge: only path and singleton arc consistency see it
+	CSPconsistency levels[] = { CSP_NODE, CSP_FORWARD, CSP_ARC, CSP_PATH, CSP_SINGLETON_ARC };
+	bool satisfiable[] = { true, true, true, false, false };
+
+	for ( size_t l=0; l < 5; l++ )  {
+		CSP<int> csp(3);
+		ring(csp, 2, true, levels[l]);
+		csp.refreshDomains();
+		CHECK(csp.isSatisfiable() == satisfiable[l]);
+
+		CSPstats stats = csp.stats();
+		CHECK(stats.runs[CSP_NODE] == 1);
+		CHECK(stats.runs[levels[l]] == 1);
+
+		if (!satisfiable[l])
+			CHECK(stats.removed[levels[l]] > 0);
+	}
+}
+
+static void
+testChain ( void )
+{
+	// Setting the first of a chain of three variables with 2 colours: forward
+	// checking only narrows its neighbour, arc consistency the whole chain
+	CSP<int> forward(3);
+	ring(forward, 2, false, CSP_FORWARD);
+	forward.setValue(0, 1);
+	forward.refreshDomains();
+	CHECK(forward.domainSize(1) == 1 && forward.domain(1)[0] == 2);
+	CHECK(forward.domainSize(2) == 2);
+
+	CSP<int> arc(3);
+	ring(arc, 2, false, CSP_ARC);
+	arc.setValue(0, 1);
+	arc.refreshDomains();
+	CHECK(arc.domainSize(1) == 1 && arc.domain(1)[0] == 2);
+	CHECK(arc.domainSize(2) == 1 && arc.domain(2)[0] == 1);
+
+	// Node consistency doesn't look at the binary constraints
+	CSP<int> node(3);
+	ring(node, 2, false, CSP_NODE);
+	node.setValue(0, 1);
+	node.refreshDomains();
+	CHECK(node.domainSize(1) == 2 && node.domainSize(2) == 2);
+	CHECK(node.isSatisfiable());
+}
+
+static void
+testNode ( void )
+{
+	// The constraints over a single variable are applied at any level
+	CSP<int> csp(3);
+	ring(csp, 3, false, CSP_NODE);
+	csp.appendConstraint(1, notOne);
+	csp.refreshDomains();
+	CHECK(csp.domainSize(0) == 3);
+	CHECK(csp.domainSize(1) == 2 && csp.domain(1)[0] != 1 && csp.domain(1)[1] != 1);
+
+	CSPstats stats = csp.stats();
+	CHECK(stats.removed[CSP_NODE] == 1);
+
+	csp.resetStats();
+	stats = csp.stats();
+	CHECK(stats.runs[CSP_NODE] == 0 && stats.removed[CSP_NODE] == 0);
+}
+
+static void
+testLevel ( void )
+{
+	CSP<int> csp(2);
+	CHECK(csp.consistency() == CSP_ARC);
+	csp.setConsistency(CSP_PATH);
+	CHECK(csp.consistency() == CSP_PATH);
+	CHECK_THROWS(csp.setConsistency((CSPconsistency) 7));
+	CHECK(csp.consistency() == CSP_PATH);
+}
+
+int
+main ( void )
+{
+	testTriangle();
+	testChain();
+	testNode();
+	testLevel();
+	CHECK_EXIT();
+}
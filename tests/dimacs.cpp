@@ -0,0 +1,116 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  dimacs.cpp
+ *
+ *    Description:  Tests of the DIMACS front end: graphs read from .col files, with
+ *                  loops and repeated edges, invalid files, and the chromatic number
+ *                  of the Groetzsch graph found through dimacsColouring()
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:24:19
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<fstream>
+#include	<string>
+#include	<cstdio>
+#include	<unistd.h>
+#include	<csp++/csp++.h>
+#include	<csp++/csp++-dimacs.h>
+#include	"check.h"
+
+using namespace std;
+
+static void
+writeFile ( const string &file, const string &data )
+{
+	ofstream out(file.c_str(), ios::trunc);
+	out << data;
+}
+
+static bool
+proper ( const CSPgraph &g, const CSP<int> &csp )
+{
+	for ( size_t i=0; i < g.edges.size(); i++ )
+		if (csp.value(g.edges[i].first) == csp.value(g.edges[i].second))
+			return false;
+
+	return true;
+}
+
+static void
+testRead ( const string &file )
+{
+	writeFile(file, "c a triangle, with a loop and an edge given twice\n"
+		"p edge 3 5\n"
+		"e 1 2\ne 2 3\ne 3 1\ne 2 2\ne 2 1\n");
+
+	CSPgraph g = readDimacsGraph(file.c_str());
+	CHECK(g.vertices == 3);
+	CHECK(g.edges.size() == 3);
+	CHECK(g.edges[0] == make_pair((size_t) 0, (size_t) 1));
+	CHECK(g.edges[2] == make_pair((size_t) 1, (size_t) 2));
+
+	writeFile(file, "e 1 2\np edge 2 1\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+	writeFile(file, "p edge 2 1\ne 1 3\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+	writeFile(file, "c no problem line\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+
+	// Negative counts and other formats are rejected, and the number of
+	// edges isn't trusted
+	writeFile(file, "p edge 3 -1\ne 1 2\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+	writeFile(file, "p edge -3 1\ne 1 2\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+	writeFile(file, "p cnf 3 1\n1 -2 0\n");
+	CHECK_THROWS(readDimacsGraph(file.c_str()));
+	writeFile(file, "p col 3 1000000000000000000\ne 1 2\n");
+	CHECK(readDimacsGraph(file.c_str()).edges.size() == 1);
+	CHECK_THROWS(readDimacsGraph("/nonexistent/graph.col"));
+}
+
+static void
+testColouring ( void )
+{
+	CSPgraph g = readDimacsGraph("myciel3.col");
+	CHECK(g.vertices == 11);
+	CHECK(g.edges.size() == 20);
+
+	// Triangle-free, but it needs 4 colours
+	CSP<int> three = dimacsColouring(g, 3);
+	CHECK(!three.optimise());
+	CHECK(three.isOptimal());
+
+	CSP<int> four = dimacsColouring(g, 4);
+	CHECK(four.optimise());
+	CHECK(proper(g, four));
+
+	CHECK_THROWS(dimacsColouring(g, 0));
+	CHECK_THROWS(dimacsColouring(g, -2));
+}
+
+int
+main ( void )
+{
+	char name[] = "/tmp/csp-dimacs-XXXXXX";
+	int fd = mkstemp(name);
+
+	if (fd < 0)
+		return 1;
+
+	close(fd);
+	testRead(name);
+	testColouring();
+	unlink(name);
+	CHECK_EXIT();
+}
@@ -0,0 +1,182 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  dsl.cpp
+ *
+ *    Description:  Tests of the constraints written as expressions: the domains and
+ *                  the number of solutions found with each lowering (binary
+ *                  relation, linear sum, generic expression, allDifferent) against
+ *                  the ones of the same constraint written as a function
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 14:02:11
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	VARS 	4
+
+static void
+domains ( CSP<int> &csp )
+{
+	int values[] = { 0, 1, 2, 3, 4 };
+
+	for ( size_t i=0; i < VARS; i++ )
+		csp.setDomain(i, values, 5);
+}
+
+// Same domains and same number of solutions in both CSPs
+static bool
+same ( CSP<int> &a, CSP<int> &b )
+{
+	a.refreshDomains();
+	b.refreshDomains();
+
+	for ( size_t i=0; i < VARS; i++ )
+		if (a.domain(i) != b.domain(i))
+			return false;
+
+	return a.countSolutions() == b.countSolutions();
+}
+
+static bool
+sum ( const vector<int> &x )
+{
+	return x[0] + x[1] == x[2];
+}
+
+static bool
+weighted ( const vector<int> &x )
+{
+	return 2*x[0] - x[1] + 3 <= x[2];
+}
+
+static bool
+implication ( const vector<int> &x )
+{
+	return x[0] != 1 || x[1] == 2;
+}
+
+static bool
+distinct ( const vector<int> &x )
+{
+	for ( size_t i=0; i < x.size(); i++ )
+		for ( size_t j=i+1; j < x.size(); j++ )
+			if (x[i] == x[j])
+				return false;
+
+	return true;
+}
+
+int
+main ( void )
+{
+	CSPvar<int> x0(0), x1(1), x2(2), x3(3);
+	size_t s[] = { 0, 1, 2 }, all[] = { 0, 1, 2, 3 };
+	vector<size_t> scope(s, s+3), every(all, all+4);
+
+	// Relation between two variables
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(x0 < x1);
+		b.appendConstraint(0, 1, CSP<int>::lessThan);
+		CHECK(same(a, b));
+		CHECK(a.domainSize(0) == 4 && a.domainSize(1) == 4);
+	}
+
+	// A variable related to itself: a single leaf, always or never satisfied
+	{
+		CSP<int> a(VARS);
+		domains(a);
+		a.appendConstraint(x0 == x0);
+		a.appendConstraint(x0 <= x0);
+		a.refreshDomains();
+		CHECK(a.domainSize(0) == 5);
+		CHECK(a.countSolutions() == 5*5*5*5);
+	}
+
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(x0 != x0);
+		b.appendConstraint(x1 < x1);
+		a.refreshDomains();
+		b.refreshDomains();
+		CHECK(a.domainSize(0) == 0 && b.domainSize(1) == 0);
+		CHECK(a.countSolutions() == 0 && b.countSolutions() == 0);
+	}
+
+	// Linear sums, propagated on the bounds
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(x0 + x1 == x2);
+		b.appendConstraint(scope, sum);
+		CHECK(same(a, b));
+		CHECK(a.countSolutions() == 15 * 5);
+	}
+
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(2 * x0 - x1 + 3 <= x2);
+		b.appendConstraint(scope, weighted);
+		CHECK(a.countSolutions() == b.countSolutions());
+		CHECK(a.domainSize(0) <= 3);
+	}
+
+	// Generic expression, evaluated inline
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(implies(x0 == 1, x1 == 2));
+		b.appendConstraint(scope, implication);
+		CHECK(same(a, b));
+		CHECK(a.countSolutions() == (4*5 + 1) * 25);
+	}
+
+	// allDifferent against the same constraint as a function
+	{
+		CSP<int> a(VARS), b(VARS);
+		domains(a);
+		domains(b);
+		a.appendConstraint(allDifferent<int>(every));
+		b.appendConstraint(every, distinct);
+		CHECK(same(a, b));
+		CHECK(a.countSolutions() == 5*4*3*2);
+	}
+
+	// Naked and hidden singles
+	{
+		CSP<int> a(VARS);
+		int one[] = { 1 }, pair[] = { 1, 2 };
+		domains(a);
+		a.setDomain(0, one, 1);
+		a.setDomain(1, pair, 2);
+		a.appendConstraint(allDifferent<int>(every));
+		a.refreshDomains();
+		CHECK(a.domainSize(1) == 1 && a.domain(1)[0] == 2);
+		CHECK(a.domainSize(2) == 3 && a.domainSize(3) == 3);
+	}
+
+	(void) x3;
+	CHECK_EXIT();
+}
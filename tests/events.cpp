@@ -0,0 +1,128 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  events.cpp
+ *
+ *    Description:  Tests of the event-driven propagation: the constraints in cheaper
+ *                  priority classes run first, and a constraint is only woken up
+ *                  again by the events it subscribed to
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:49:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<string>
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static string trace;
+static size_t calls = 0;
+
+static bool
+binary ( int a, int b )
+{
+	trace += 'b';
+	return a != b;
+}
+
+static bool
+global ( const vector<int> &v )
+{
+	trace += 'g';
+	return v[0] + v[1] + v[2] != 0;
+}
+
+static bool
+lessCounted ( int a, int b )
+{
+	calls++;
+	return a < b;
+}
+
+static void
+testPriorities ( void )
+{
+	int values[] = { 1, 2, 3 };
+	CSP<int> csp(3);
+	vector<size_t> scope;
+
+	for ( size_t i=0; i < 3; i++ )  {
+		csp.setDomain(i, values, 3);
+		scope.push_back(i);
+	}
+
+	// The global constraint is appended first, but waits for the binary one
+	csp.appendConstraint(scope, global, CSP_PRIORITY_GLOBAL);
+	csp.appendConstraint(0, 1, binary);
+	csp.refreshDomains();
+	CHECK(!trace.empty());
+	CHECK(trace.find('g') != string::npos);
+	CHECK(trace.find('b') < trace.find('g'));
+
+	trace.clear();
+	csp.setValue(0, 1);
+	csp.refreshDomains();
+	CHECK(trace.find('b') < trace.find('g'));
+	CHECK(csp.domainSize(1) == 2);
+}
+
+// Counts the solutions of x0 < x1, x0 != x2, x1 != x3, with x0 and x1 in
+// 1 .. 5, x2 in { 2, 3 } and x3 in { 3, 4 }, and x0 < x1 woken up by the given
+// events. The search sets x2 and x3 first, which removes values from the
+// middle of the domains of x0 and x1
+static size_t
+count ( unsigned events, size_t &checked )
+{
+	int values[] = { 1, 2, 3, 4, 5 };
+	int middle[] = { 2, 3, 4 };
+	CSP<int> csp(4);
+
+	csp.setDomain(0, values, 5);
+	csp.setDomain(1, values, 5);
+	csp.setDomain(2, middle, 2);
+	csp.setDomain(3, middle + 1, 2);
+
+	csp.appendConstraint(0, 1, lessCounted, events);
+	csp.appendConstraint(0, 2, CSP<int>::notEqual);
+	csp.appendConstraint(1, 3, CSP<int>::notEqual);
+
+	calls = 0;
+	size_t solutions = csp.countSolutions();
+	checked = calls;
+	return solutions;
+}
+
+static void
+testEvents ( void )
+{
+	size_t domain, bounds, fixed;
+
+	// The same solutions whatever wakes up the constraint
+	CHECK(count(CSP_EVENT_DOMAIN, domain) == 23);
+	CHECK(count(CSP_EVENT_BOUNDS, bounds) == 23);
+	CHECK(count(CSP_EVENT_FIXED, fixed) == 23);
+
+	// ... but removing a value from the middle of a domain doesn't wake up
+	// the constraint subscribed to the bounds or to fixed domains
+	CHECK(bounds < domain);
+	CHECK(fixed < domain);
+}
+
+int
+main ( void )
+{
+	testPriorities();
+	testEvents();
+	CHECK_EXIT();
+}
@@ -0,0 +1,103 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  grid.cpp
+ *
+ *    Description:  Tests of CSPgrid: the units and the peers of the cells, the
+ *                  number of solutions of the empty grids, the givens propagated
+ *                  by the allDifferent constraints and the grids read from a file
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:38:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<cstdio>
+#include	<fstream>
+#include	<vector>
+#include	<csp++/csp++-grid.h>
+#include	"check.h"
+
+using namespace std;
+
+int
+main ( void )
+{
+	// Units and peers of the usual 9x9 grid
+	CSPgrid nine;
+	CHECK(nine.side() == 9 && nine.cells() == 81 && nine.units().size() == 27);
+	CHECK(nine.box(nine.cell(4, 7)) == 5 && nine.box(nine.cell(8, 0)) == 6);
+
+	bool peers = true;
+
+	for ( size_t c=0; c < nine.cells(); c++ )
+		peers = peers && nine.peers(c).size() == 20;
+
+	CHECK(peers);
+	CHECK(nine.peers(0)[0] == 1 && nine.peers(0).back() == nine.cell(8, 0));
+
+	// Rectangular boxes
+	CSPgrid six(2, 3);
+	CHECK(six.side() == 6 && six.boxRows() == 2 && six.boxColumns() == 3);
+	CHECK(six.box(six.cell(1, 4)) == 1 && six.box(six.cell(2, 0)) == 2);
+	CHECK(six.peers(0).size() == 5 + 5 + 2);
+	CHECK_THROWS(CSPgrid(0, 3));
+
+	// The 4x4 grids
+	CSPgrid four(2);
+	CSP<int> empty = four.model();
+	CHECK(empty.countSolutions() == 288);
+
+	int g[] = {
+		1, 0, 0, 0,
+		0, 0, 3, 0,
+		0, 4, 0, 0,
+		0, 0, 0, 2,
+	};
+
+	vector<int> givens(g, g+16);
+	CSP<int> puzzle = four.model(givens);
+	puzzle.refreshDomains();
+
+	// Solved by the naked and hidden singles alone
+	bool singles = true;
+
+	for ( size_t c=0; c < four.cells(); c++ )
+		singles = singles && puzzle.domainSize(c) == 1;
+
+	CHECK(singles);
+	CHECK(puzzle.countSolutions() == 1);
+
+	givens[1] = 5;
+	CHECK_THROWS(four.model(givens));
+	givens.pop_back();
+	CHECK_THROWS(four.model(givens));
+
+	// Read back from a file, with the borders skipped
+	const char *file = "tests/grid.tmp";
+	ofstream out(file);
+	out << "# six by six\n"
+		<< "1 0 0 | 0 0 0\n0 0 0 | 0 2 0\n------+------\n"
+		<< "0 0 3 | 0 0 0\n0 0 0 | 4 0 0\n------+------\n"
+		<< "0 5 0 | 0 0 0\n0 0 0 | 0 0 6\n";
+	out.close();
+
+	CSPgrid read = readGrid(file, givens);
+	CHECK(read.boxRows() == 2 && read.boxColumns() == 3);
+	CHECK(givens.size() == 36 && givens[0] == 1 && givens[10] == 2 && givens[35] == 6);
+
+	out.open(file);
+	out << "1 2 3\n4 5 6\n";
+	out.close();
+	CHECK_THROWS(readGrid(file, givens));
+
+	remove(file);
+	CHECK_EXIT();
+}
@@ -0,0 +1,144 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  incremental.cpp
+ *
+ *    Description:  Tests of the incremental propagation of appended and removed
+ *                  constraints: the domains found after each change against the
+ *                  ones of a CSP built from scratch with the same constraints
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 01:58:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<cstdlib>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	VARS 	8
+
+struct Edge  {
+	size_t x, y;
+	int relation;
+	size_t id;
+};
+
+static bool (*relations[])(int, int) = { CSP<int>::notEqual, CSP<int>::lessThan, CSP<int>::equal };
+
+static void
+domains ( CSP<int> &csp )
+{
+	int values[] = { 0, 1, 2, 3, 4 };
+
+	for ( size_t i=0; i < VARS; i++ )
+		csp.setDomain(i, values, 5);
+}
+
+// The domains of a CSP built from scratch with the edges still present
+static bool
+sameAsScratch ( const CSP<int> &csp, const vector<Edge> &edges, const vector<char> &present )
+{
+	CSP<int> scratch(VARS);
+	domains(scratch);
+
+	for ( size_t i=0; i < edges.size(); i++ )
+		if (present[i])
+			scratch.appendConstraint(edges[i].x, edges[i].y, relations[edges[i].relation]);
+
+	scratch.refreshDomains();
+
+	// Once a domain is wiped out, the others don't matter
+	if (!scratch.isSatisfiable() || !csp.isSatisfiable())
+		return scratch.isSatisfiable() == csp.isSatisfiable();
+
+	for ( size_t i=0; i < VARS; i++ )
+		if (scratch.domain(i) != csp.domain(i))
+			return false;
+
+	return true;
+}
+
+static bool
+twoIfSet ( vector< CSPvariable<int> > v )
+{
+	return !v[1].fixed || v[1].value == 2;
+}
+
+int
+main ( void )
+{
+	srand(3);
+
+	for ( size_t t=0; t < 100; t++ )  {
+		CSP<int> csp(VARS);
+		vector<Edge> edges;
+		vector<char> present;
+		bool same = true;
+
+		domains(csp);
+		csp.refreshDomains();
+
+		for ( size_t step=0; step < 20; step++ )  {
+			size_t alive = std::count(present.begin(), present.end(), 1);
+
+			// Remove a constraint once in a while, otherwise append one
+			if (alive && rand() % 3 == 0)  {
+				size_t k;
+
+				do
+					k = rand() % edges.size();
+				while (!present[k]);
+
+				csp.removeConstraint(edges[k].id);
+				present[k] = 0;
+			} else {
+				Edge e;
+				e.x = rand() % VARS;
+
+				do
+					e.y = rand() % VARS;
+				while (e.y == e.x);
+
+				e.relation = rand() % 3;
+				e.id = csp.appendConstraint(e.x, e.y, relations[e.relation]);
+				edges.push_back(e);
+				present.push_back(1);
+			}
+
+			csp.refreshDomains();
+			same = same && sameAsScratch(csp, edges, present);
+		}
+
+		CHECK(same);
+	}
+
+	// A constraint over the whole set of variables appended and dropped
+	CSP<int> csp(VARS);
+	domains(csp);
+	csp.setProbeFixed(true);
+	csp.appendConstraint(0, 1, CSP<int>::lessThan);
+	csp.refreshDomains();
+	CHECK(csp.domainSize(1) == 4);
+
+	csp.appendConstraint(twoIfSet);
+	csp.refreshDomains();
+	CHECK(csp.domainSize(1) == 1 && csp.domain(1)[0] == 2);
+	CHECK(csp.domainSize(0) == 2);
+
+	// The first one is the default constraint, always true
+	csp.dropConstraint(1);
+	csp.refreshDomains();
+	CHECK(csp.domainSize(1) == 4 && csp.domainSize(0) == 4);
+	CHECK_EXIT();
+}
@@ -0,0 +1,129 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  inference.cpp
+ *
+ *    Description:  Tests of inferScopes(): the constraints over the whole set of
+ *                  variables split into constraints between two variables, with
+ *                  the same domains and solutions as when probed, and the ones
+ *                  left to the probing (over more than two variables, or
+ *                  rejecting no pair at all)
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:55:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	VARS 	4
+
+static void
+domains ( CSP<int> &csp )
+{
+	int values[] = { 1, 2, 3, 4 };
+
+	for ( size_t i=0; i < VARS; i++ )
+		csp.setDomain(i, values, 4);
+}
+
+// The set variables take different values, and the first one is not 4
+static bool
+distinct ( vector< CSPvariable<int> > v )
+{
+	if (v[0].fixed && v[0].value == 4)
+		return false;
+
+	for ( size_t i=0; i < v.size(); i++ )
+		for ( size_t j=i+1; j < v.size(); j++ )
+			if (v[i].fixed && v[j].fixed && v[i].value == v[j].value)
+				return false;
+
+	return true;
+}
+
+// Over three variables: no pair of values is ever rejected
+static bool
+sum ( vector< CSPvariable<int> > v )
+{
+	return !(v[0].fixed && v[1].fixed && v[2].fixed) || v[0].value + v[1].value + v[2].value != 6;
+}
+
+// Reads the value of the second variable even when it isn't set
+static bool
+careless ( vector< CSPvariable<int> > v )
+{
+	return !v[0].fixed || v[0].value != v[1].value;
+}
+
+int
+main ( void )
+{
+	// Split into constraints between two variables, which remove the same
+	// values as the probing with the probed variables marked as set
+	{
+		CSP<int> probed(VARS, distinct), inferred(VARS, distinct);
+		domains(probed);
+		domains(inferred);
+		probed.setProbeFixed(true);
+		CHECK(inferred.inferScopes() == 1);
+
+		probed.setValue(1, 2);
+		inferred.setValue(1, 2);
+		probed.refreshDomains();
+		inferred.refreshDomains();
+
+		bool same = true;
+
+		for ( size_t i=0; i < VARS; i++ )
+			same = same && probed.domain(i) == inferred.domain(i);
+
+		CHECK(same);
+		CHECK(inferred.domainSize(0) == 2);
+		CHECK(probed.countSolutions() == inferred.countSolutions());
+		CHECK(inferred.countSolutions() == 4);
+	}
+
+	// A constraint over three variables rejects no pair, so it is still probed
+	{
+		CSP<int> csp(VARS, sum);
+		domains(csp);
+		CHECK(csp.inferScopes() == 0);
+		CHECK(csp.countSolutions() == 4*4*4*4 - 10*4);
+	}
+
+	// With two constraints, only the one made of pairs is split
+	{
+		CSP<int> csp(VARS, distinct);
+		domains(csp);
+		csp.appendConstraint(sum);
+		CHECK(csp.inferScopes() == 1);
+		CHECK(csp.countSolutions() == 4*3*2*1 - 3*2*1 - 6);
+	}
+
+	// The unset variables hold the same value whatever they held before
+	{
+		CSP<int> fresh(VARS, careless), used(VARS, careless);
+		domains(fresh);
+		domains(used);
+		used.setValue(1, 2);
+		used.unsetValue(1);
+
+		CHECK(fresh.inferScopes() == 1);
+		CHECK(used.inferScopes() == 1);
+		CHECK(fresh.countSolutions() == used.countSolutions());
+	}
+
+	CHECK_EXIT();
+}
@@ -0,0 +1,71 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  interning.cpp
+ *
+ *    Description:  Tests of CSPinterned: the values translated back from the ids,
+ *                  the order of the ids of the values given to the constructor and
+ *                  the values rejected once that order is fixed
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:31:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<string>
+#include	<vector>
+#include	<csp++/csp++-intern.h>
+#include	"check.h"
+
+using namespace std;
+
+int
+main ( void )
+{
+	const char *n[] = { "red", "green", "blue" };
+	vector<string> names(n, n+3);
+
+	// Ids in the order the values are interned
+	CSPdictionary<string> dict;
+	CHECK(dict.intern("b") == 0 && dict.intern("a") == 1 && dict.intern("b") == 0);
+	CHECK(dict.size() == 2 && dict.value(1) == "a" && dict.id("b") == 0);
+	CHECK_THROWS(dict.id("c"));
+	CHECK_THROWS(dict.value(2));
+
+	// Without the values in the constructor, any value is interned on the fly
+	CSPinterned<string> free(2);
+	free.setDomain(0, names);
+	free.setDomain(1, names);
+	free.csp().appendConstraint(0, 1, CSP<int>::notEqual);
+	free.setValue(0, "green");
+	free.csp().refreshDomains();
+	CHECK(free.value(0) == "green");
+	CHECK(free.domain(1).size() == 2 && free.domain(1)[0] == "red" && free.domain(1)[1] == "blue");
+	CHECK(free.id("yellow") == 3);
+
+	// With them, the ids compare like the values and the set of values is closed
+	CSPinterned<string> ordered(2, names);
+	CHECK(ordered.id("blue") < ordered.id("green") && ordered.id("green") < ordered.id("red"));
+	ordered.setDomain(0, names);
+	ordered.setDomain(1, names);
+	ordered.csp().appendConstraint(0, 1, CSP<int>::lessThan);
+	ordered.csp().refreshDomains();
+	CHECK(ordered.domain(0).size() == 2 && ordered.domain(1).size() == 2);
+	CHECK(ordered.domain(1)[0] != "blue");
+
+	CHECK_THROWS(ordered.id("yellow"));
+	CHECK_THROWS(ordered.setValue(0, "yellow"));
+	names.push_back("yellow");
+	CHECK_THROWS(ordered.setDomain(0, names));
+	CHECK(ordered.dictionary().size() == 3);
+
+	CHECK(ordered.csp().countSolutions() == 3);
+	CHECK_EXIT();
+}
@@ -0,0 +1,188 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  kernels.cpp
+ *
+ *    Description:  Tests of the whole-domain checks: the comparison kernels (SSE2
+ *                  ones included, for ints) against plain loops, and the support
+ *                  functions of the built-in relations against the relations
+ *                  checked on each pair of values
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 00:04:16
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<cstdlib>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static bool
+compare ( int a, int b, __csp_cmp op )
+{
+	switch (op)  {
+		case __CSP_EQ: return a == b;
+		case __CSP_NE: return a != b;
+		case __CSP_LT: return a < b;
+		case __CSP_GT: return a > b;
+		case __CSP_LE: return a <= b;
+		default:       return a >= b;
+	}
+}
+
+static vector<int>
+randomValues ( size_t n )
+{
+	vector<int> v(n);
+
+	for ( size_t i=0; i < n; i++ )
+		v[i] = rand() % 21 - 10;
+
+	return v;
+}
+
+// The values of a domain are all different
+static vector<int>
+randomDomain ( size_t n )
+{
+	vector<int> v;
+
+	for ( int i=-20; i <= 20; i++ )
+		v.push_back(i);
+
+	for ( size_t i=v.size()-1; i > 0; i-- )
+		std::swap(v[i], v[rand() % (i+1)]);
+
+	v.resize(std::min(n, v.size()));
+	return v;
+}
+
+static void
+testMasks ( void )
+{
+	__csp_cmp ops[] = { __CSP_EQ, __CSP_NE, __CSP_LT, __CSP_GT, __CSP_LE, __CSP_GE };
+
+	// Lengths around the 16 values of each SSE2 block, and the tails
+	for ( size_t n=0; n < 70; n++ )  {
+		vector<int> v = randomValues(n);
+		vector<char> mask(n + 1, 7), reference(n + 1, 7);
+		int b = rand() % 21 - 10;
+
+		for ( size_t o=0; o < 6; o++ )  {
+			__csp_mask(n ? &v[0] : NULL, n, b, ops[o], &mask[0]);
+
+			for ( size_t i=0; i < n; i++ )
+				reference[i] = compare(v[i], b, ops[o]);
+
+			CHECK(mask == reference);
+		}
+
+		// The or'ed mask keeps the bits already set
+		for ( size_t i=0; i < n; i++ )
+			reference[i] = mask[i] = (i % 3 == 0);
+
+		__csp_mask_or(n ? &v[0] : NULL, n, b, &mask[0]);
+
+		for ( size_t i=0; i < n; i++ )
+			reference[i] |= (v[i] == b);
+
+		CHECK(mask == reference);
+
+		if (n == 0)
+			continue;
+
+		int lo, hi;
+		__csp_minmax(&v[0], n, lo, hi);
+		CHECK(lo == *min_element(v.begin(), v.end()));
+		CHECK(hi == *max_element(v.begin(), v.end()));
+	}
+}
+
+typedef void (*support)(const int*, size_t, const int*, size_t, bool, char*);
+
+static void
+testSupports ( void )
+{
+	support supports[] = { CSP<int>::notEqualSupport, CSP<int>::lessThanSupport, CSP<int>::equalSupport };
+	bool (*relations[])(int, int) = { CSP<int>::notEqual, CSP<int>::lessThan, CSP<int>::equal };
+
+	for ( size_t t=0; t < 300; t++ )  {
+		vector<int> x = randomDomain(1 + rand() % 40);
+		vector<int> y = randomDomain(1 + rand() % (t % 2 ? 2 : 40));
+
+		for ( size_t r=0; r < 3; r++ )  {
+			for ( int first=0; first < 2; first++ )  {
+				vector<char> mask(x.size(), 7);
+				bool ok = true;
+
+				supports[r](&x[0], x.size(), &y[0], y.size(), first, &mask[0]);
+
+				// A value of x has a support if it's in relation with some
+				// value of y, on the side given by first
+				for ( size_t i=0; i < x.size(); i++ )  {
+					bool supported = false;
+
+					for ( size_t j=0; j < y.size() && !supported; j++ )
+						supported = first ? relations[r](x[i], y[j]) : relations[r](y[j], x[i]);
+
+					ok = ok && (mask[i] != 0) == supported;
+				}
+
+				CHECK(ok);
+			}
+		}
+	}
+}
+
+static void
+testPropagation ( void )
+{
+	// The same domains whether the relation is checked on pairs of values or
+	// on whole domains
+	for ( size_t t=0; t < 50; t++ )  {
+		vector<int> a = randomDomain(1 + rand() % 10), b = randomDomain(1 + rand() % 10);
+		vector<int> c = randomDomain(1 + rand() % 10);
+		CSP<int> pairs(3), domains(3);
+
+		pairs.setDomain(0, a);
+		pairs.setDomain(1, b);
+		pairs.setDomain(2, c);
+		domains.setDomain(0, a);
+		domains.setDomain(1, b);
+		domains.setDomain(2, c);
+
+		pairs.appendConstraint(0, 1, CSP<int>::lessThan);
+		pairs.appendConstraint(1, 2, CSP<int>::equal);
+		domains.appendConstraint(0, 1, CSP<int>::lessThanSupport);
+		domains.appendConstraint(1, 2, CSP<int>::equalSupport);
+		pairs.refreshDomains();
+		domains.refreshDomains();
+
+		for ( size_t i=0; i < 3; i++ )  {
+			vector<int> p = pairs.domain(i), d = domains.domain(i);
+			sort(p.begin(), p.end());
+			sort(d.begin(), d.end());
+			CHECK(p == d);
+		}
+	}
+}
+
+int
+main ( void )
+{
+	srand(1);
+	testMasks();
+	testSupports();
+	testPropagation();
+	CHECK_EXIT();
+}
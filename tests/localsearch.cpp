@@ -0,0 +1,111 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  localsearch.cpp
+ *
+ *    Description:  Tests of localSearch(): solutions of the n queens, the variables
+ *                  already set left untouched, the violations left on a CSP without
+ *                  solutions, and the same moves for the same seed
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 01:48:06
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<cstdlib>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	QUEENS 	16
+
+// Two queens are on different rows and diagonals. The value of each queen
+// holds both its column and its row, as 100 * column + row
+static bool
+safe ( int a, int b )
+{
+	return a % 100 != b % 100 && abs(a % 100 - b % 100) != abs(a / 100 - b / 100);
+}
+
+static void
+queens ( CSP<int> &csp )
+{
+	for ( size_t i=0; i < QUEENS; i++ )  {
+		vector<int> rows;
+
+		for ( int r=0; r < QUEENS; r++ )
+			rows.push_back(100 * i + r);
+
+		csp.setDomain(i, rows);
+	}
+
+	for ( size_t i=0; i < QUEENS; i++ )
+		for ( size_t j=i+1; j < QUEENS; j++ )
+			csp.appendConstraint(i, j, safe);
+}
+
+static bool
+solved ( const CSP<int> &csp )
+{
+	for ( size_t i=0; i < QUEENS; i++ )  {
+		if (!csp.isSet(i))
+			return false;
+
+		for ( size_t j=i+1; j < QUEENS; j++ )
+			if (!safe(csp.value(i), csp.value(j)))
+				return false;
+	}
+
+	return true;
+}
+
+int
+main ( void )
+{
+	CSP<int> csp(QUEENS);
+	queens(csp);
+	CHECK(csp.localSearch(100000) == 0);
+	CHECK(solved(csp));
+
+	// The variables already set stay where they are
+	CSP<int> fixed(QUEENS);
+	queens(fixed);
+	fixed.setValue(0, 0);
+	fixed.setValue(5, 502);
+	CHECK(fixed.localSearch(100000, 0.05, 3, 7) == 0);
+	CHECK(solved(fixed));
+	CHECK(fixed.value(0) == 0 && fixed.value(5) == 502);
+
+	// The same seed makes the same moves
+	CSP<int> again(QUEENS);
+	queens(again);
+	again.setValue(0, 0);
+	again.setValue(5, 502);
+	CHECK(again.localSearch(100000, 0.05, 3, 7) == 0);
+
+	for ( size_t i=0; i < QUEENS; i++ )
+		CHECK(again.value(i) == fixed.value(i));
+
+	// A triangle with two colours always leaves one edge violated
+	int colours[] = { 0, 1 };
+	CSP<int> triangle(3);
+
+	for ( size_t i=0; i < 3; i++ )
+		triangle.setDomain(i, colours, 2);
+
+	triangle.appendConstraint(0, 1, CSP<int>::notEqual);
+	triangle.appendConstraint(1, 2, CSP<int>::notEqual);
+	triangle.appendConstraint(2, 0, CSP<int>::notEqual);
+	CHECK(triangle.localSearch(1000) == 1);
+	CHECK(triangle.isSet(0) && triangle.isSet(1) && triangle.isSet(2));
+	CHECK_EXIT();
+}
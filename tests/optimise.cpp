@@ -0,0 +1,170 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  optimise.cpp
+ *
+ *    Description:  Tests of the branch-and-bound search of optimise(), on objectives
+ *                  given as a variable and as a function of the variables, and of
+ *                  the way the constraints over the whole set of variables see the
+ *                  variables probed by refreshDomains()
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 22:34:50
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static bool
+isGreater ( int a, int b )
+{
+	return a > b;
+}
+
+static bool
+sumAtLeastSeven ( vector< CSPvariable<int> > v )
+{
+	int sum = 0;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		if (!v[i].fixed)
+			return true;
+
+		sum += v[i].value;
+	}
+
+	return sum >= 7;
+}
+
+static double
+squares ( vector< CSPvariable<int> > v )
+{
+	double cost = 0;
+
+	// Only the set variables count, so the cost of a partial assignment is a
+	// lower bound of the cost of its completions
+	for ( size_t i=0; i < v.size(); i++ )
+		if (v[i].fixed)
+			cost += v[i].value * v[i].value;
+
+	return cost;
+}
+
+static bool
+twoIfSet ( vector< CSPvariable<int> > v )
+{
+	return !v[1].fixed || v[1].value == 2;
+}
+
+static void
+testVariableObjective ( void )
+{
+	int values[] = { 1, 2, 3, 4, 5 };
+
+	// a > b, minimising a gives a = 2
+	CSP<int> min(2);
+	min.setDomain(0, values, 5);
+	min.setDomain(1, values, 5);
+	min.appendConstraint(0, 1, isGreater);
+	min.setObjective((size_t) 0);
+
+	CHECK(min.optimise());
+	CHECK(min.isOptimal());
+	CHECK(min.objectiveValue() == 2);
+	CHECK(min.value(0) == 2 && min.value(1) == 1);
+
+	// ... and maximising b gives b = 4
+	CSP<int> max(2);
+	max.setDomain(0, values, 5);
+	max.setDomain(1, values, 5);
+	max.appendConstraint(0, 1, isGreater);
+	max.setObjective(1, true);
+
+	CHECK(max.optimise());
+	CHECK(max.isOptimal());
+	CHECK(max.objectiveValue() == 4);
+	CHECK(max.value(0) == 5 && max.value(1) == 4);
+}
+
+static void
+testFunctionObjective ( void )
+{
+	int values[] = { 0, 1, 2, 3, 4 };
+
+	// Three values summing to at least 7 with the smallest sum of squares:
+	// 2, 2, 3 in any order, with cost 17
+	CSP<int> csp(3, sumAtLeastSeven);
+
+	for ( size_t i=0; i < 3; i++ )
+		csp.setDomain(i, values, 5);
+
+	csp.setObjective(squares);
+	CHECK(csp.optimise());
+	CHECK(csp.isOptimal());
+	CHECK(csp.objectiveValue() == 17);
+	CHECK(csp.value(0) + csp.value(1) + csp.value(2) == 7);
+}
+
+static void
+testUnsatisfiable ( void )
+{
+	int values[] = { 1, 2 };
+	CSP<int> csp(3);
+
+	// No strictly decreasing sequence of three values out of two
+	for ( size_t i=0; i < 3; i++ )
+		csp.setDomain(i, values, 2);
+
+	csp.appendConstraint(0, 1, isGreater);
+	csp.appendConstraint(1, 2, isGreater);
+	csp.setObjective((size_t) 0);
+
+	CHECK(!csp.optimise());
+	CHECK(csp.isOptimal());
+}
+
+static void
+testProbeContract ( void )
+{
+	int x[] = { 1 };
+	int y[] = { 1, 2 };
+
+	// By default the probed variables are not marked as set, so a constraint
+	// only checking the set variables doesn't prune anything
+	CSP<int> plain(2, twoIfSet);
+	plain.setDomain(0, x, 1);
+	plain.setDomain(1, y, 2);
+	plain.refreshDomains();
+	CHECK(plain.domainSize(1) == 2);
+
+	// ... while with setProbeFixed(true) it sees the values being tried
+	CSP<int> fixed(2, twoIfSet);
+	fixed.setDomain(0, x, 1);
+	fixed.setDomain(1, y, 2);
+	fixed.setProbeFixed(true);
+	fixed.refreshDomains();
+	CHECK(fixed.domainSize(1) == 1);
+	CHECK(fixed.domain(1)[0] == 2);
+	CHECK(!fixed.isSet(0) && !fixed.isSet(1));
+}
+
+int
+main ( void )
+{
+	testVariableObjective();
+	testFunctionObjective();
+	testUnsatisfiable();
+	testProbeContract();
+	CHECK_EXIT();
+}
@@ -0,0 +1,105 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ordering.cpp
+ *
+ *    Description:  Tests of the order in which the constraints over the whole set
+ *                  of variables are checked: the order learnt from their profiles,
+ *                  with the slow constraints rejecting nothing put last, and the
+ *                  solutions left unchanged by it
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:59:02
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<algorithm>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	VARS 	5
+
+static void
+domains ( CSP<int> &csp )
+{
+	int values[] = { 0, 1, 2, 3, 4 };
+
+	for ( size_t i=0; i < VARS; i++ )
+		csp.setDomain(i, values, 5);
+}
+
+// Always true, but slow
+static bool
+slow ( const CSPview<int> &v )
+{
+	volatile double x = 0;
+
+	for ( int i=0; i < 2000; i++ )
+		x += i * 0.5;
+
+	return v.size() > 0;
+}
+
+// The set variables take increasing values
+static bool
+increasing ( const CSPview<int> &v )
+{
+	for ( size_t i=0; i+1 < v.size(); i++ )
+		if (v.isSet(i) && v.isSet(i+1) && v.value(i) >= v.value(i+1))
+			return false;
+
+	return true;
+}
+
+static size_t
+position ( const vector<size_t> &order, size_t c )
+{
+	return std::find(order.begin(), order.end(), c) - order.begin();
+}
+
+int
+main ( void )
+{
+	CSP<int> plain(VARS), profiled(VARS);
+	domains(plain);
+	domains(profiled);
+	plain.appendConstraint(increasing);
+
+	// Appended first, so checked first until the constraints are sorted again
+	profiled.appendConstraint(slow);
+	profiled.appendConstraint(increasing);
+	profiled.setProbeFixed(true);
+
+	CSPstats before = profiled.stats();
+	CHECK(before.reorders == 0);
+	CHECK(position(before.order, 0) < position(before.order, 1));
+
+	size_t solutions = profiled.countSolutions();
+	CSPstats after = profiled.stats();
+
+	CHECK(solutions == plain.countSolutions());
+	CHECK(solutions == 1);
+	CHECK(after.reorders > 0);
+	CHECK(after.order.size() == 2);
+	CHECK(position(after.order, 1) < position(after.order, 0));
+
+	// The profiles are kept by resetStats(), and dropped with the constraints
+	profiled.resetStats();
+	CHECK(profiled.stats().reorders == 0);
+	CHECK(position(profiled.stats().order, 1) < position(profiled.stats().order, 0));
+
+	profiled.appendConstraint(increasing);
+	CHECK(profiled.stats().order.size() == 3);
+	CHECK(position(profiled.stats().order, 0) < position(profiled.stats().order, 1));
+	CHECK_EXIT();
+}
@@ -0,0 +1,134 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  solverd.cpp
+ *
+ *    Description:  Tests of the solver service, run on its standard input: answers
+ *                  to sudoku and colouring requests, including many requests for
+ *                  the same model at once, and the requests refused because of their
+ *                  size, their graph path or the length of their line
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 01:23:57
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<fstream>
+#include	<sstream>
+#include	<string>
+#include	<map>
+#include	<cstdio>
+#include	<cstdlib>
+#include	<unistd.h>
+#include	"check.h"
+
+using namespace std;
+
+static const char *puzzle = "6.8...9.42...14.5...79.3....2.5....9.3.4.851.8....9......3.27...5.74...89.4...3.6";
+
+// Run the service on the given requests, and return its answers by id
+static map<string, string>
+run ( const string &requests )
+{
+	char in[] = "/tmp/csp-solverd-in-XXXXXX", out[] = "/tmp/csp-solverd-out-XXXXXX";
+	map<string, string> answers;
+	int fd;
+
+	if ((fd = mkstemp(in)) < 0)
+		return answers;
+	close(fd);
+
+	if ((fd = mkstemp(out)) < 0)
+		return answers;
+	close(fd);
+
+	ofstream(in) << requests;
+	string cmd = string("./solverd -t 4 -g . < ") + in + " > " + out;
+	CHECK(system(cmd.c_str()) == 0);
+
+	ifstream answer(out);
+	string line;
+
+	while (getline(answer, line))  {
+		size_t start = line.find("{\"id\":\"") + 7;
+		answers[line.substr(start, line.find('"', start) - start)] = line;
+	}
+
+	unlink(in);
+	unlink(out);
+	return answers;
+}
+
+static bool
+has ( const map<string, string> &answers, const string &id, const string &what )
+{
+	map<string, string>::const_iterator it = answers.find(id);
+	return it != answers.end() && it->second.find(what) != string::npos;
+}
+
+int
+main ( void )
+{
+	ostringstream requests;
+
+	// The same models asked for by many requests at once
+	for ( int i=0; i < 16; i++ )  {
+		requests << "s" << i << " sudoku " << puzzle << "\n";
+		requests << "c" << i << " colour myciel3.col\n";
+	}
+
+	requests << "k3 colour myciel3.col colours=3\n";
+	requests << "k4 colour myciel3.col colours=4\n";
+	requests << "huge colour myciel3.col colours=2000000000\n";
+	requests << "negative colour myciel3.col colours=-4\n";
+	requests << "absolute colour /etc/passwd\n";
+	requests << "outside colour ../../../../../../../../etc/passwd\n";
+	requests << "missing colour nonexistent.col\n";
+	requests << "big sudoku " << string(9*9*9*9, '0') << "\n";
+	requests << "odd sudoku 123\n";
+	requests << "unknown solve 1\n";
+
+	// A graph with a broken header, which once took the whole service down
+	ofstream("tests/solverd-bad.col") << "p edge 3 -1\ne 1 2\n";
+	requests << "bad colour tests/solverd-bad.col\n";
+	requests << "after colour myciel3.col\n";
+
+	map<string, string> answers = run(requests.str());
+	unlink("tests/solverd-bad.col");
+
+	for ( int i=0; i < 16; i++ )  {
+		ostringstream s, c;
+		s << "s" << i;
+		c << "c" << i;
+		CHECK(has(answers, s.str(), "\"status\":\"solved\",\"values\":[6,1,8,2,7,5,9,3,4,"));
+		CHECK(has(answers, c.str(), "\"status\":\"solved\",\"colours\":4,\"optimal\":true"));
+	}
+
+	CHECK(has(answers, "k3", "\"status\":\"unsatisfiable\""));
+	CHECK(has(answers, "k4", "\"status\":\"solved\",\"colours\":4"));
+	CHECK(has(answers, "huge", "\"status\":\"solved\",\"colours\":4"));
+	CHECK(has(answers, "negative", "Invalid number of colours"));
+	CHECK(has(answers, "absolute", "relative to the graph directory"));
+	CHECK(has(answers, "outside", "inside the graph directory"));
+	CHECK(has(answers, "missing", "Unable to read the graph file"));
+	CHECK(has(answers, "big", "too large"));
+	CHECK(has(answers, "odd", "not n^4"));
+	CHECK(has(answers, "unknown", "Unknown request"));
+	CHECK(has(answers, "bad", "\"status\":\"error\""));
+	CHECK(has(answers, "after", "\"status\":\"solved\",\"colours\":4"));
+	CHECK(answers.size() == 44);
+
+	// A line too long ends the requests: the ones before it are answered,
+	// the ones after it aren't read
+	answers = run("before colour myciel3.col\n" + string(2 << 20, 'x') + "\nafter colour myciel3.col\n");
+	CHECK(has(answers, "before", "\"status\":\"solved\""));
+	CHECK(answers.size() == 1);
+	CHECK_EXIT();
+}
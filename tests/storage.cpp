@@ -0,0 +1,218 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  storage.cpp
+ *
+ *    Description:  Tests of the structure-of-arrays storage of the variables: what
+ *                  the constraints taking a CSPview see, against the constraints
+ *                  taking the vector of variables, over more variables than a word
+ *                  of the bitmap of the set flags holds
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 00:47:13
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<algorithm>
+#include	<stdint.h>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	N 	70
+
+// Hashes of the state seen by each call of the constraints
+static vector<uint64_t> byVectorStates, byViewStates;
+
+static void
+mix ( uint64_t &h, uint64_t v )
+{
+	h = (h ^ v) * 1099511628211ULL;
+}
+
+static bool
+byVector ( vector< CSPvariable<int> > v )
+{
+	uint64_t h = 14695981039346656037ULL;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		mix(h, v[i].fixed);
+		mix(h, v[i].fixed ? v[i].value : -1);
+		mix(h, v[i].domain.size());
+
+		for ( size_t j=0; j < v[i].domain.size(); j++ )
+			mix(h, v[i].domain[j]);
+	}
+
+	byVectorStates.push_back(h);
+	return true;
+}
+
+static bool
+byView ( const CSPview<int> &v )
+{
+	uint64_t h = 14695981039346656037ULL;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		mix(h, v.isSet(i));
+		mix(h, v.isSet(i) ? v.value(i) : -1);
+		mix(h, v.domainSize(i));
+
+		for ( size_t j=0; j < v.domainSize(i); j++ )
+			mix(h, v.domain(i)[j] + v.domainSpan(i)[j] - v.domain(i)[j]);
+	}
+
+	byViewStates.push_back(h);
+	return true;
+}
+
+// The variables left set take increasing values
+static bool
+increasing ( const CSPview<int> &v )
+{
+	long last = -1;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		if (!v.isSet(i))
+			continue;
+
+		if (v.value(i) <= last)
+			return false;
+
+		last = v.value(i);
+	}
+
+	return true;
+}
+
+static bool
+increasingVector ( vector< CSPvariable<int> > v )
+{
+	long last = -1;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		if (!v[i].fixed)
+			continue;
+
+		if (v[i].value <= last)
+			return false;
+
+		last = v[i].value;
+	}
+
+	return true;
+}
+
+static void
+testView ( void )
+{
+	int values[] = { 0, 1, 2, 3 };
+	CSP<int> csp(N);
+
+	for ( size_t i=0; i < N; i++ )
+		csp.setDomain(i, values, 1 + i % 3);
+
+	// Set flags in the first and second words of the bitmap
+	csp.setValue(0, 0);
+	csp.setValue(63, 0);
+	csp.setValue(64, 1);
+	csp.setValue(69, 0);
+
+	csp.setConstraint(byVector);
+	csp.appendConstraint(byView);
+	csp.refreshDomains();
+	// Both constraints are checked on the same states
+	CHECK(!byViewStates.empty());
+	CHECK(byViewStates == byVectorStates);
+
+	CSPview<int> view = csp.view();
+	CHECK(view.size() == N);
+	CHECK(view.isSet(63) && view.isSet(64) && !view.isSet(65) && view.isSet(69));
+	CHECK(view.values()[64] == 1 && view.value(69) == 0);
+	CHECK(csp.domainSpan(2).size() == 3 && csp.domainSize(2) == 3);
+}
+
+static void
+testSame ( void )
+{
+	// The same constraint written on the view and on the vector
+	int values[] = { 0, 1, 2, 3, 4 };
+	CSP<int> view(4), vec(4, increasingVector);
+
+	for ( size_t i=0; i < 4; i++ )  {
+		view.setDomain(i, values, 5);
+		vec.setDomain(i, values, 5);
+	}
+
+	view.appendConstraint(increasing);
+	view.setProbeFixed(true);
+	vec.setProbeFixed(true);
+
+	// 5 choose 4 increasing sequences
+	CHECK(view.countSolutions() == 5);
+	CHECK(vec.countSolutions() == 5);
+
+	view.setValue(1, 1);
+	vec.setValue(1, 1);
+	view.refreshDomains();
+	vec.refreshDomains();
+
+	for ( size_t i=0; i < 4; i++ )
+		CHECK(view.domain(i) == vec.domain(i));
+
+	CHECK(view.domainSize(0) == 1 && view.domain(0)[0] == 0);
+}
+
+// The domains are sorted and without duplicates, whatever the order of the
+// values given to setDomain(), and stay so while values are removed
+static void
+testSorted ( void )
+{
+	int d[] = { 3, 1, 2, 1 }, one[] = { 1, 1 }, e[] = { 5, 4, 3, 2, 1 };
+	CSP<int> csp(3, byVector);
+	vector<int> expected;
+
+	csp.setDomain(0, d, 4);
+	csp.setDomain(1, one, 2);
+	csp.setDomain(2, vector<int>(e, e+5));
+	csp.appendConstraint(2, 0, CSP<int>::notEqual);
+	csp.refreshDomains();
+
+	expected.push_back(1);
+	expected.push_back(2);
+	expected.push_back(3);
+	CHECK(csp.domain(0) == expected);
+	CHECK(csp.domainSize(1) == 1 && csp.domain(1)[0] == 1);
+
+	csp.setValue(0, 2);
+	csp.refreshDomains();
+
+	expected.assign(e, e+5);
+	expected.erase(expected.begin() + 3);
+	std::reverse(expected.begin(), expected.end());
+	CHECK(csp.domain(2) == expected);
+
+	// A domain of a single value given twice is a single value
+	CSP<int> unique(1);
+	unique.setDomain(0, one, 2);
+	unique.refreshDomains();
+	CHECK(unique.hasUniqueSolution());
+}
+
+int
+main ( void )
+{
+	testView();
+	testSame();
+	testSorted();
+	CHECK_EXIT();
+}
@@ -0,0 +1,149 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  symmetry.cpp
+ *
+ *    Description:  Tests of the symmetry breaking: the solutions counted with and
+ *                  without interchangeable values and symmetries of the variables,
+ *                  and the optimum found by optimise() when breaking them
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 22:52:07
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static bool
+differ ( int a, int b )
+{
+	return a != b;
+}
+
+static double
+weighted ( vector< CSPvariable<int> > v )
+{
+	double cost = 0;
+
+	for ( size_t i=0; i < v.size(); i++ )
+		if (v[i].fixed)
+			cost += (i+1) * v[i].value;
+
+	return cost;
+}
+
+static double
+used ( vector< CSPvariable<int> > v )
+{
+	vector<char> seen(4, 0);
+	double count = 0;
+
+	for ( size_t i=0; i < v.size(); i++ )  {
+		if (v[i].fixed && !seen[v[i].value])  {
+			seen[v[i].value] = 1;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// Colourings of the path 0 - 1 - 2 with the colours 1, 2 and 3
+static void
+path ( CSP<int> &csp )
+{
+	int colours[] = { 1, 2, 3 };
+
+	for ( size_t i=0; i < 3; i++ )
+		csp.setDomain(i, colours, 3);
+
+	csp.appendConstraint(0, 1, differ);
+	csp.appendConstraint(1, 2, differ);
+}
+
+static void
+testCounts ( void )
+{
+	CSP<int> csp(3);
+	path(csp);
+
+	// 3 * 2 * 2 colourings
+	CHECK(csp.countSolutions() == 12);
+
+	// Up to a permutation of the colours, only a-b-a and a-b-c are left
+	vector<int> colours;
+	colours.push_back(1);
+	colours.push_back(2);
+	colours.push_back(3);
+	csp.addInterchangeableValues(colours);
+	CHECK(csp.countSolutions() == 2);
+	csp.clearSymmetries();
+	CHECK(csp.countSolutions() == 12);
+
+	// Reversing the path maps the 6 colourings a-b-a to themselves, and the
+	// other 6 to each other
+	vector<size_t> reverse;
+	reverse.push_back(2);
+	reverse.push_back(1);
+	reverse.push_back(0);
+	csp.addVariableSymmetry(reverse);
+	CHECK(csp.countSolutions() == 9);
+
+	// Both together
+	csp.addInterchangeableValues(colours);
+	CHECK(csp.countSolutions() == 2);
+	CHECK(csp.countSolutions(1) == 1);
+
+	// The variables are left untouched
+	CHECK(!csp.isSet(0) && !csp.isSet(1) && !csp.isSet(2));
+}
+
+static void
+testOptimum ( void )
+{
+	// The cheapest colouring with weights 1, 2, 3 is 1-2-1, with cost 8
+	CSP<int> csp(3);
+	path(csp);
+	csp.setObjective(weighted);
+	CHECK(csp.optimise());
+	CHECK(csp.objectiveValue() == 8);
+
+	// The number of colours used doesn't change permuting the colours or
+	// reversing the path, and breaking both symmetries keeps the optimum of 2
+	CSP<int> broken(3);
+	path(broken);
+	broken.setObjective(used);
+	vector<int> colours;
+	colours.push_back(1);
+	colours.push_back(2);
+	colours.push_back(3);
+	broken.addInterchangeableValues(colours);
+	vector<size_t> reverse;
+	reverse.push_back(2);
+	reverse.push_back(1);
+	reverse.push_back(0);
+	broken.addVariableSymmetry(reverse);
+	CHECK(broken.optimise());
+	CHECK(broken.isOptimal());
+	CHECK(broken.objectiveValue() == 2);
+	CHECK(broken.value(0) == broken.value(2) && broken.value(0) != broken.value(1));
+}
+
+int
+main ( void )
+{
+	testCounts();
+	testOptimum();
+	CHECK_EXIT();
+}
@@ -0,0 +1,127 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  trace.cpp
+ *
+ *    Description:  Tests of the Chrome Trace Event export: the events written for a
+ *                  search, balanced begin and end events, and ring buffers too
+ *                  small for all the events
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 00:36:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<fstream>
+#include	<string>
+#include	<vector>
+#include	<cstdio>
+#include	<unistd.h>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+static size_t
+occurrences ( const string &s, const string &what )
+{
+	size_t n = 0;
+
+	for ( size_t i = s.find(what); i != string::npos; i = s.find(what, i + 1) )
+		n++;
+
+	return n;
+}
+
+// Check that no scope ends before beginning, and return the depth left
+static long
+depth ( const string &s )
+{
+	long d = 0;
+
+	for ( size_t i = s.find("\"ph\":\""); i != string::npos; i = s.find("\"ph\":\"", i + 1) )  {
+		char phase = s[i + 6];
+
+		if (phase == 'B')
+			d++;
+		else if (phase == 'E' && --d < 0)
+			return -1;
+	}
+
+	return d;
+}
+
+static string
+traced ( const string &file, size_t capacity )
+{
+	int values[] = { 1, 2, 3 };
+	CSP<int> csp(4);
+
+	for ( size_t i=0; i < 4; i++ )
+		csp.setDomain(i, values, 3);
+
+	for ( size_t i=0; i+1 < 4; i++ )
+		csp.appendConstraint(i, i+1, CSP<int>::notEqual);
+
+	CSPtrace::start(file, capacity);
+	CHECK(CSPtrace::enabled());
+	CHECK(csp.countSolutions() == 24);
+	CSPtrace::stop();
+	CHECK(!CSPtrace::enabled());
+
+	ifstream in(file.c_str());
+	return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+int
+main ( void )
+{
+	char name[] = "/tmp/csp-trace-XXXXXX";
+	int fd = mkstemp(name);
+
+	if (fd < 0)
+		return 1;
+
+	close(fd);
+
+	// All the events are kept
+	string json = traced(name, 65536);
+	CHECK(json.substr(0, 2) == "[\n" && json.substr(json.size() - 3) == "\n]\n");
+	CHECK(occurrences(json, "\"name\":\"search\"") == 2);
+	CHECK(occurrences(json, "\"name\":\"decision\"") > 0);
+	CHECK(occurrences(json, "\"ph\":\"i\"") > 0);
+	CHECK(occurrences(json, "\"ph\":\"B\"") == occurrences(json, "\"ph\":\"E\""));
+	CHECK(depth(json) == 0);
+
+	// Only the latest events are kept, and the ends of the scopes whose
+	// beginning was overwritten are dropped
+	json = traced(name, 16);
+	CHECK(occurrences(json, "\"ph\":") <= 16);
+	CHECK(depth(json) >= 0);
+
+	// A scope still open when tracing is stopped records nothing into the
+	// freed rings, and the next trace is written into new ones
+	CSPtrace::start(name, 16);
+
+	{
+		__csp_trace_scope scope("open");
+		CSPtrace::stop();
+	}
+
+	json = traced(name, 65536);
+	CHECK(occurrences(json, "\"name\":\"open\"") == 0);
+	CHECK(depth(json) == 0);
+
+	// An empty ring buffer is refused
+	CHECK_THROWS(CSPtrace::start(name, 0));
+	CHECK(!CSPtrace::enabled());
+	unlink(name);
+	CHECK_EXIT();
+}
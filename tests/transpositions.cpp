@@ -0,0 +1,142 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  transpositions.cpp
+ *
+ *    Description:  Tests of the transposition table: its slots, the domains
+ *                  replayed from it against the ones propagated without it, and
+ *                  the CSPs whose results are found again (the copies of a CSP)
+ *                  and not (the CSPs built apart, changed since, or with
+ *                  constraints over the whole set of variables)
+ *
+ *        Version:  0.1.1
+ *        Created:  18/10/2026 23:47:16
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  BlackLight (http://0x00.ath.cx), <blacklight@autistici.org>
+ *        Licence:  GNU GPL v.3
+ *        Company:  lulz
+ *
+ * =====================================================================================
+ */
+
+#include	<vector>
+#include	<csp++/csp++.h>
+#include	"check.h"
+
+using namespace std;
+
+#define	VARS 	6
+
+static CSP<int>
+chain ( void )
+{
+	CSP<int> csp(VARS);
+	int values[] = { 0, 1, 2, 3, 4, 5, 6 };
+
+	for ( size_t i=0; i < VARS; i++ )
+		csp.setDomain(i, values, 7);
+
+	for ( size_t i=0; i+1 < VARS; i++ )
+		csp.appendConstraint(i, i+1, CSP<int>::lessThan);
+
+	return csp;
+}
+
+static bool
+sameDomains ( const CSP<int> &a, const CSP<int> &b )
+{
+	for ( size_t i=0; i < VARS; i++ )
+		if (a.domain(i) != b.domain(i))
+			return false;
+
+	return true;
+}
+
+static bool
+anything ( vector< CSPvariable<int> > )
+{
+	return true;
+}
+
+int
+main ( void )
+{
+	// The slots of the table
+	CSPtranspositions small(100);
+	vector<uint32_t> in(3, 7), out;
+	bool consistent = false;
+
+	CHECK(small.capacity() == 128);
+	CHECK(!small.find(42, consistent, NULL));
+	small.store(42, false, NULL);
+	CHECK(small.find(42, consistent, NULL) && !consistent);
+	CHECK(!small.find(42, consistent, &out));
+	small.store(42, true, &in);
+	CHECK(small.find(42, consistent, &out) && consistent && out == in);
+
+	// A result with its domains isn't replaced by the same one without them
+	small.store(42, true, NULL);
+	CHECK(small.find(42, consistent, &out) && out == in);
+
+	// The same slot, another key
+	small.store(42 + 128, false, NULL);
+	CHECK(!small.find(42, consistent, NULL));
+	small.clear();
+	CHECK(!small.find(42 + 128, consistent, NULL));
+
+	CSPtranspositions table;
+	CSP<int> plain = chain();
+	plain.setValue(2, 3);
+	plain.refreshDomains();
+
+	// The copies of a CSP find its results, and replay the same domains
+	CSP<int> model = chain();
+	model.setTranspositions(&table);
+	CSP<int> first(model), second(model);
+	first.setValue(2, 3);
+	first.refreshDomains();
+	CHECK(sameDomains(first, plain));
+
+	second.resetStats();
+	second.setValue(2, 3);
+	second.refreshDomains();
+	CHECK(second.stats().lookups > 0 && second.stats().hits > 0);
+	CHECK(sameDomains(second, plain));
+
+	// A CSP built apart with the same constraints doesn't
+	CSP<int> apart = chain();
+	apart.setTranspositions(&table);
+	apart.resetStats();
+	apart.setValue(2, 3);
+	apart.refreshDomains();
+	CHECK(apart.stats().lookups > 0 && apart.stats().hits == 0);
+	CHECK(sameDomains(apart, plain));
+
+	// Neither does a copy whose constraints changed
+	CSP<int> changed(model);
+	changed.appendConstraint(0, 5, CSP<int>::notEqual);
+	changed.resetStats();
+	changed.setValue(2, 3);
+	changed.refreshDomains();
+	CHECK(changed.stats().hits == 0);
+
+	// The table isn't used with a constraint over the whole set of variables
+	CSP<int> legacy(model);
+	legacy.appendConstraint(anything);
+	legacy.resetStats();
+	legacy.setValue(2, 3);
+	legacy.refreshDomains();
+	CHECK(legacy.stats().lookups == 0 && legacy.stats().hits == 0);
+	CHECK(sameDomains(legacy, plain));
+
+	// Nor after the table is taken away
+	CSP<int> detached(model);
+	detached.setTranspositions(NULL);
+	detached.resetStats();
+	detached.setValue(2, 3);
+	detached.refreshDomains();
+	CHECK(detached.stats().lookups == 0);
+	CHECK_EXIT();
+}